@@ -21,50 +21,154 @@
 // SOFTWARE.
 
 #include "NonBlockingDallas.h"
+#include "NonBlockingDallasHistory.h"
+#include "NonBlockingDallasEventQueue.h"
+#include "NonBlockingDallasTrace.h"
+#include "NonBlockingDallasStats.h"
+#include "NonBlockingDallasSnapshot.h"
+#include "NonBlockingDallasTimings.h"
+#include "NonBlockingDallasChangeFilter.h"
+#include "NonBlockingDallasThresholds.h"
+#include "NonBlockingDallasAdaptive.h"
+#include "NonBlockingDallasConversionTimes.h"
 
-NonBlockingDallas::NonBlockingDallas(DallasTemperature *dallasTemp)
+uint8_t nbdInvalidAddressCharacter()
+{
+	return 0;
+}
+
+NonBlockingDallasBase::NonBlockingDallasBase(DallasTemperature *dallasTemp, OneWire *oneWire, const sensorStorage &storage)
 {
 	_dallasTemp = dallasTemp;
+	_capacity = storage.capacity;
+	_lookupMask = storage.lookupSize - 1;
+	_temperatures = storage.temperatures;
+	_sensorAddresses = storage.addresses;
+	_sensorIntervals = storage.intervals;
+	_sensorDueMillis = storage.dueMillis;
+	_sensorFlags = storage.flags;
+	_addressLookup = storage.lookup;
+	_validMask = storage.validMask;
+	_changedMask = storage.changedMask;
+	_minChangeInterval = 0;
+	_adaptiveMinInterval = 0;
+	_adaptiveMaxInterval = 0;
+	_adaptiveStable = 0;
+	_adaptiveMargin = 0;
+	_farResolution = resolution_12;
+	_nearResolution = resolution_12;
+	_nearResolutionRAW = 0;
+	_restoreResolution = false;
+	_alarmSweepCycles = 0;
+	_alarmCycle = 0;
+	_timedWait = false;
+	_cycleResolution = 12;
+	_expectedConversionMillis = 0;
+	_nextPollMillis = 0;
+	_pollStepMillis = 0;
+	_cycleCount = 0;
+	_cacheUnverified = false;
+	_cacheFailed = false;
+	_fullReadCycles = 0;
+	_fastReadCycle = 0;
+	_maxJump = 0;
+	_skipRom = true;
+	_singleDevice = false;
+	_sweepDevices = 0;
+	_oneWire = oneWire;
+	_history = NULL;
+	_resolution = resolution_12;
 	_sensorsCount = 0;
 	_lastReadingMillis = 0;
 	_startConversionMillis = 0;
+	_lastRequestMillis = 0;
+	_requestIndex = 0;
 	_conversionMillis = 0;
+	_readIndex = 0;
+	_indexOffset = 0;
+	_tableGeneration = 0;
+	_sensorsPerUpdate = 0;
+	_readBudgetMicros = 0;
+	_mergeWindow = 0;
+	_mergeWindowSet = false;
+	_discoveryBits = DEFAULT_DISCOVERY_BITS;
+	_discoveryInterval = DEFAULT_INTERVAL;
+	_discoveryIntervalSet = false;
+	_lastSweepMillis = 0;
+	_sweepRunning = false;
+	_searchBit = 0;
+	_searchLastDiscrepancy = 0;
+	_searchLastZero = 0;
 	_currentState = notFound;
 	cb_onIntervalElapsed = NULL;
 	cb_onTemperatureChange = NULL;
-	for (int i = 0; i < ONE_WIRE_MAX_DEV; i++)
+	cb_onDeviceDisconnected = NULL;
+	cb_onCycleComplete = NULL;
+	cb_onScheduleChange = NULL;
+	_eventQueue = NULL;
+	_trace = NULL;
+	_stats = NULL;
+	_snapshot = NULL;
+	_timings = NULL;
+	_changeFilter = NULL;
+	_thresholds = NULL;
+	_adaptive = NULL;
+	_conversionTimes = NULL;
+	for (int i = 0; i < (_capacity + 7) / 8; i++)
+	{
+		_validMask[i] = 0;
+		_changedMask[i] = 0;
+	}
+	for (int i = 0; i < _capacity; i++)
+	{
 		_temperatures[i] = DEVICE_DISCONNECTED_RAW;
+		_sensorIntervals[i] = 0;
+		_sensorDueMillis[i] = 0;
+		_sensorFlags[i] = 0;
+	}
+	clearAddressLookup();
 }
 
-void NonBlockingDallas::begin(resolution res, unsigned long tempInterval)
+void NonBlockingDallasBase::begin(resolution res, unsigned long tempInterval)
 {
 	_tempInterval = tempInterval;
+	_resolution = res;
 	_currentState = notFound;
-	_conversionMillis = 750 / (1 << (12 - (uint8_t)res)); // Rough calculation of sensors conversion time
-	_dallasTemp->begin();
+	_cacheUnverified = false;
+	_restoreResolution = false; // All the sensors get res
+	_conversionMillis = resolutionMillis((uint8_t)res); // Rough calculation of sensors conversion time
+	if (!_mergeWindowSet)
+		_mergeWindow = _conversionMillis;
+	_sensorsCount = busEnumerate();
+	_singleDevice = _sensorsCount == 1;
 	delay(50);
 	_dallasTemp->setWaitForConversion(false); // Avoid blocking the CPU waiting for the sensors conversion
-	_sensorsCount = _dallasTemp->getDeviceCount();
+	if (_sensorsCount > _capacity)
+		_sensorsCount = _capacity;
+	clearAddressLookup();
 
 	if (_sensorsCount > 0)
 	{
 		_currentState = waitingNextReading;
-		_dallasTemp->setResolution((uint8_t)res);
+		busSetResolution(0xFF, (uint8_t)res);
 		for (int i = 0; i < _sensorsCount; i++)
 		{
-			_dallasTemp->getAddress(_sensorAddresses[i], i);
+			busGetAddress(i, _sensorAddresses[i]);
+			addToAddressLookup(i);
+			if (_adaptive)
+				_adaptive->setResolution(i, (uint8_t)res);
+			_sensorDueMillis[i] = NBD_MILLIS();
+			_sensorFlags[i] = 0;
 		}
 	}
 
-	if ((_tempInterval < _conversionMillis) || (_tempInterval > 4294967295UL))
-	{
-		_tempInterval = DEFAULT_INTERVAL;
-
-#ifdef DEBUG_DS18B20
-		Serial.print("DS18B20: temperature interval not valid. Setting the default value: ");
-		Serial.println(DEFAULT_INTERVAL);
-#endif
-	}
+	// With the discovery running, sensors plugged after begin() are added to the table
+	if (_oneWire != NULL && _discoveryBits > 0)
+		_currentState = waitingNextReading;
+	validateInterval();
+	if (!_discoveryIntervalSet)
+		_discoveryInterval = _tempInterval;
+	_lastSweepMillis = NBD_MILLIS();
 
 #ifdef DEBUG_DS18B20
 	Serial.print("DS18B20: ");
@@ -73,7 +177,7 @@ void NonBlockingDallas::begin(resolution res, unsigned long tempInterval)
 	if (_sensorsCount > 0)
 	{
 		Serial.print("DS18B20: parasite power is ");
-		if (_dallasTemp->isParasitePowerMode())
+		if (busParasite())
 			Serial.print("ON");
 		else
 			Serial.print("OFF");
@@ -82,59 +186,676 @@ void NonBlockingDallas::begin(resolution res, unsigned long tempInterval)
 #endif
 }
 
+/**
+ * @brief Start from an address table saved by exportCache(), without searching the bus
+ *
+ * The first conversion is requested by the next update(). The table is verified by the first
+ * readout: if a sensor does not answer the bus is searched again, by the discovery when the
+ * OneWire instance is available, otherwise by begin(). Sensors added since the table was saved
+ * are found by the discovery only. A cache not valid, or a bus in parasite power mode, which
+ * DallasTemperature detects only while searching, falls back to begin().
+ *
+ * @return false if begin() was used
+ */
+bool NonBlockingDallasBase::beginFromCache(const uint8_t *cache, size_t cacheSize, resolution res, unsigned long tempInterval)
+{
+	uint8_t count = cacheSize >= getCacheSize(0) ? cache[3] : 0;
+	bool valid = count > 0 && count <= _capacity && cacheSize >= getCacheSize(count) &&
+				 cache[0] == 'N' && cache[1] == 'B' && cache[2] == 1;
+	if (valid)
+	{
+		size_t crcOffset = getCacheSize(count) - 2;
+		uint16_t crc = OneWire::crc16(cache, crcOffset);
+		valid = cache[crcOffset] == (crc & 0xFF) && cache[crcOffset + 1] == (crc >> 8);
+	}
+	if (!valid || busReadPowerSupply())
+	{
+		begin(res, tempInterval);
+		return false;
+	}
+
+	_tempInterval = tempInterval;
+	_resolution = res;
+	_currentState = waitingNextReading;
+	_conversionMillis = resolutionMillis((uint8_t)res);
+	if (!_mergeWindowSet)
+		_mergeWindow = _conversionMillis;
+	_dallasTemp->setWaitForConversion(false); // Avoid blocking the CPU waiting for the sensors conversion
+	_sensorsCount = count;
+	_singleDevice = false; // Confirmed by the first discovery sweep
+	_restoreResolution = false; // The sensors keep the cached resolutions
+	clearAddressLookup();
+
+	const uint8_t *entry = cache + 4;
+	for (int i = 0; i < _sensorsCount; i++, entry += 9)
+	{
+		for (uint8_t b = 0; b < 8; b++)
+			_sensorAddresses[i][b] = entry[b];
+		addToAddressLookup(i);
+		if (_adaptive)
+			_adaptive->setResolution(i, entry[8] >= 9 && entry[8] <= 12 ? entry[8] : (uint8_t)res);
+		_sensorDueMillis[i] = NBD_MILLIS();
+		_sensorFlags[i] = 0;
+	}
+
+	// The first sweep runs as soon as the bus is idle, to find the sensors added meanwhile
+	validateInterval();
+	if (!_discoveryIntervalSet)
+		_discoveryInterval = _tempInterval;
+	_lastSweepMillis = NBD_MILLIS() - _discoveryInterval;
+	_cacheUnverified = true;
+	_cacheFailed = false;
+
+#ifdef DEBUG_DS18B20
+	Serial.print("DS18B20: ");
+	Serial.print(_sensorsCount);
+	Serial.println(" sensors loaded from the cache");
+#endif
+
+	return true;
+}
+
+/**
+ * @brief Save the address table and the resolution of each sensor, to be passed to beginFromCache()
+ *
+ * Layout: 'N', 'B', version 1, sensors count, then 8 address bytes and 1 resolution byte
+ * for each sensor, then the CRC16 of all the previous bytes, little endian.
+ *
+ * @return number of bytes written, 0 if cacheSize is smaller than getCacheSize()
+ */
+size_t NonBlockingDallasBase::exportCache(uint8_t *cache, size_t cacheSize)
+{
+	size_t size = getCacheSize(_sensorsCount);
+	if (cacheSize < size)
+		return 0;
+
+	cache[0] = 'N';
+	cache[1] = 'B';
+	cache[2] = 1;
+	cache[3] = _sensorsCount;
+	uint8_t *entry = cache + 4;
+	for (int i = 0; i < _sensorsCount; i++, entry += 9)
+	{
+		for (uint8_t b = 0; b < 8; b++)
+			entry[b] = _sensorAddresses[i][b];
+		entry[8] = sensorResolution(i);
+	}
+	uint16_t crc = OneWire::crc16(cache, size - 2);
+	cache[size - 2] = crc & 0xFF;
+	cache[size - 1] = crc >> 8;
+	return size;
+}
+
+/**
+ * @brief Write the valid readings of the last cycle as a packed record, call it from onCycleComplete
+ *
+ * Layout, little endian: 'N', 'C', version 1, samples count, cycle number (uint32, see getCycleCount()),
+ * start of the cycle (uint32, NBD_MILLIS() at the conversion request), then for each valid sensor:
+ * index with the offset (uint8), temperature RAW (int16), conversion request and readout since the
+ * start of the cycle (uint16 each, milliseconds, 0xFFFF without attachTimings()).
+ *
+ * @return number of bytes written, 0 if bufferSize is too small, getCycleRecordSize(getSensorsCount()) always fits
+ */
+size_t NonBlockingDallasBase::exportCycle(uint8_t *buffer, size_t bufferSize)
+{
+	uint8_t samples = 0;
+	for (int i = 0; i < _sensorsCount; i++)
+	{
+		if (isMaskSet(_validMask, i))
+			samples++;
+	}
+	size_t size = getCycleRecordSize(samples);
+	if (bufferSize < size)
+		return 0;
+
+	uint32_t cycle = _cycleCount;
+	buffer[0] = 'N';
+	buffer[1] = 'C';
+	buffer[2] = 1;
+	buffer[3] = samples;
+	for (uint8_t b = 0; b < 4; b++)
+	{
+		buffer[4 + b] = (cycle >> (8 * b)) & 0xFF;
+		buffer[8 + b] = (_startConversionMillis >> (8 * b)) & 0xFF;
+	}
+
+	uint8_t *sample = buffer + 12;
+	for (int i = 0; i < _sensorsCount; i++)
+	{
+		if (!isMaskSet(_validMask, i))
+			continue;
+		int16_t rawTemp = (int16_t)_temperatures[i];
+		sample[0] = i + _indexOffset;
+		sample[1] = rawTemp & 0xFF;
+		sample[2] = (rawTemp >> 8) & 0xFF;
+		uint16_t conversionDelta = _timings ? _timings->getConversionDelta(i) : 0xFFFF;
+		uint16_t readDelta = _timings ? _timings->getReadDelta(i) : 0xFFFF;
+		sample[3] = conversionDelta & 0xFF;
+		sample[4] = conversionDelta >> 8;
+		sample[5] = readDelta & 0xFF;
+		sample[6] = readDelta >> 8;
+		sample += 7;
+	}
+	return size;
+}
+
+/**
+ * @brief Time of the conversion request and of the readout of a sensor in the last cycle [milliseconds]
+ *
+ * @return false without attachTimings(), if the index does not exist or the sensor was not read in the last cycle
+ */
+bool NonBlockingDallasBase::getSampleTimes(uint8_t deviceIndex, unsigned long &conversionMillis, unsigned long &readMillis)
+{
+	if (!_timings || !this->indexExist(deviceIndex))
+		return false;
+	return _timings->getSampleTimes(deviceIndex, conversionMillis, readMillis);
+}
+
 //==============================================================================================
 //									PRIVATE
 //==============================================================================================
 
-void NonBlockingDallas::waitNextReading()
+void NonBlockingDallasBase::waitNextReading()
+{
+	unsigned long now = NBD_MILLIS();
+	uint8_t pendingCount = 0;
+	bool due = false;
+
+	// The alarm registers are written while no conversion is running, one sensor per call
+	if (_alarmSweepCycles > 0 && programAlarms())
+		return;
+
+	for (int i = 0; i < _sensorsCount; i++)
+	{
+		if (_sensorFlags[i] & flagMissing)
+		{
+			_sensorFlags[i] &= ~flagPending;
+			continue;
+		}
+
+		// Signed difference, keeps working when millis() overflows
+		long dueIn = (long)(_sensorDueMillis[i] - now);
+		if (dueIn <= 0)
+			due = true;
+		if (dueIn <= (long)_mergeWindow)
+		{
+			_sensorFlags[i] |= flagPending;
+			pendingCount++;
+		}
+		else
+			_sensorFlags[i] &= ~flagPending;
+	}
+
+	// Sensors within the merge window wait until at least one sensor is actually due.
+	// Meanwhile the bus is idle and the discovery can use it
+	if (!due)
+	{
+		discoverStep();
+		return;
+	}
+
+	for (int i = 0; i < _sensorsCount; i++)
+	{
+		if (!(_sensorFlags[i] & flagPending))
+			continue;
+
+		// Keep the sensor phase so that sensors with related intervals stay aligned
+		unsigned long interval = effectiveInterval(i);
+		_sensorDueMillis[i] += interval;
+		if ((long)(_sensorDueMillis[i] - now) <= 0)
+			_sensorDueMillis[i] = now + interval;
+	}
+
+	requestConversion(pendingCount);
+}
+
+void NonBlockingDallasBase::requestConversion(uint8_t pendingCount)
+{
+	uint8_t presentCount = 0;
+	for (int i = 0; i < _sensorsCount; i++)
+	{
+		if (!(_sensorFlags[i] & flagMissing))
+			presentCount++;
+	}
+
+	if (presentCount < 1 || pendingCount < 1)
+	{
+#ifdef DEBUG_DS18B20
+		Serial.print("DS18B20: no sensors found on the bus");
+		Serial.println("");
+#endif
+
+		return;
+	}
+
+	_currentState = waitingConversion;
+	_readIndex = 0;
+	for (int i = 0; i < (_capacity + 7) / 8; i++)
+	{
+		_validMask[i] = 0;
+		_changedMask[i] = 0;
+	}
+	_searchBit = 0; // The conversion command ends the search pass in progress, it restarts later
+	_startConversionMillis = NBD_MILLIS();
+	if (_timings)
+		_timings->startCycle(_startConversionMillis);
+	if (_fullReadCycles > 0 && ++_fastReadCycle >= _fullReadCycles)
+		_fastReadCycle = 0; // The readout of this conversion is CRC checked
+
+	// The bus reports the end of the slowest conversion, the sensor with the longest learned time
+	_cycleResolution = 0;
+	_expectedConversionMillis = 0;
+	bool broadcast = pendingCount * 2 >= presentCount || busParasite();
+	for (int i = 0; i < _sensorsCount; i++)
+	{
+		bool converting = broadcast ? !(_sensorFlags[i] & flagMissing) : (_sensorFlags[i] & flagPending);
+		if (!converting)
+			continue;
+		if (sensorResolution(i) > _cycleResolution)
+			_cycleResolution = sensorResolution(i);
+		if (getConversionMillis(i) > _expectedConversionMillis)
+			_expectedConversionMillis = getConversionMillis(i);
+	}
+	// Addressed conversions pay a Match ROM each, a broadcast is cheaper as soon as many sensors are due.
+	// In parasite mode a following command would cut the strong pullup of the previous conversion
+	if (broadcast)
+	{
+		busRequest(0xFF); // Requests a temperature conversion for all the sensors on the bus
+		for (int i = 0; _timings && i < _sensorsCount; i++)
+		{
+			if (!(_sensorFlags[i] & flagMissing))
+				_timings->recordConversion(i, _startConversionMillis);
+		}
+		startWaiting();
+	}
+	else
+	{
+		// Addressed requests are sliced like the readout, the first slice is sent at once
+		_currentState = requestingConversion;
+		_requestIndex = 0;
+		requestSensors();
+	}
+
+#ifdef DEBUG_DS18B20
+	Serial.print("DS18B20: requested new reading of ");
+	Serial.print(pendingCount);
+	Serial.println(" sensors");
+#endif
+}
+
+void NonBlockingDallasBase::requestSensors()
+{
+	unsigned long startMicros = NBD_MICROS();
+	unsigned long sensorMicros = 0;
+	uint8_t sensorsRequested = 0;
+
+	while (_requestIndex < _sensorsCount)
+	{
+		if (!(_sensorFlags[_requestIndex] & flagPending))
+		{
+			_requestIndex++;
+			continue;
+		}
+
+		// Same limits as the readout, at least one sensor is requested on each call
+		if (_readBudgetMicros > 0 && sensorsRequested > 0 && (NBD_MICROS() - startMicros) + sensorMicros > _readBudgetMicros)
+			return;
+		if (_sensorsPerUpdate > 0 && sensorsRequested >= _sensorsPerUpdate)
+			return;
+
+		unsigned long sensorStartMicros = NBD_MICROS();
+		if (_timings)
+			_timings->recordConversion(_requestIndex, NBD_MILLIS());
+		busRequest(_requestIndex++);
+		sensorMicros = NBD_MICROS() - sensorStartMicros;
+		sensorsRequested++;
+	}
+
+	startWaiting();
+}
+
+// The conversions are timed from the last request, the sensors requested before it end earlier
+void NonBlockingDallasBase::startWaiting()
+{
+	_currentState = waitingConversion;
+	_lastRequestMillis = NBD_MILLIS();
+	// Polling starts a little before the expected end, so that a shorter conversion is learned too
+	_nextPollMillis = _lastRequestMillis + _expectedConversionMillis - _expectedConversionMillis / 8;
+	_pollStepMillis = 1;
+}
+
+void NonBlockingDallasBase::waitConversion()
+{
+	unsigned long now = NBD_MILLIS();
+
+	if (busParasite())
+	{
+		// Reading the bus would cut the strong pullup powering the conversion, the datasheet time is waited
+		if (now - _lastRequestMillis < resolutionMillis(_cycleResolution))
+			return;
+	}
+	else if (_timedWait)
+	{
+		// No read slots until the expected end of the conversion, then polls spaced more and more
+		if ((long)(now - _nextPollMillis) < 0)
+			return;
+		if (!busConversionComplete())
+		{
+			_nextPollMillis = now + _pollStepMillis;
+			if (_pollStepMillis < _expectedConversionMillis / 8)
+				_pollStepMillis *= 2;
+			return;
+		}
+		learnConversion(now - _lastRequestMillis);
+	}
+	else
+	{
+		if (!busConversionComplete())
+			return;
+		learnConversion(now - _lastRequestMillis);
+	}
+
+	// Save the actual sensor conversion time to precisely calculate the next reading time
+	_conversionMillis = now - _lastRequestMillis;
+	_currentState = readingSensor;
+
+	// In alarm mode only the sensors out of their thresholds are read, except for a periodic full readout
+	if (_alarmSweepCycles > 0 && ++_alarmCycle < _alarmSweepCycles)
+	{
+		for (int i = 0; i < _sensorsCount; i++)
+			_sensorFlags[i] &= ~flagAlarmed;
+		busResetAlarmSearch();
+		_currentState = searchingAlarms;
+	}
+	else
+		_alarmCycle = 0;
+}
+
+void NonBlockingDallasBase::readSensors()
+{
+	unsigned long startMicros = NBD_MICROS();
+	unsigned long sensorMicros = 0;
+	uint8_t sensorsRead = 0;
+
+	while (_readIndex < _sensorsCount)
+	{
+		// Sensors not part of the conversion are skipped without counting against the slice
+		if (!(_sensorFlags[_readIndex] & flagPending))
+		{
+			_readIndex++;
+			continue;
+		}
+
+		// Stop when the next sensor would exceed the budget, at least one sensor is read on each call
+		if (_readBudgetMicros > 0 && sensorsRead > 0 && (NBD_MICROS() - startMicros) + sensorMicros > _readBudgetMicros)
+			break;
+		if (_sensorsPerUpdate > 0 && sensorsRead >= _sensorsPerUpdate)
+			break;
+
+		unsigned long sensorStartMicros = NBD_MICROS();
+		_sensorFlags[_readIndex] &= ~flagPending;
+		readTemperatures(_readIndex++);
+		sensorMicros = NBD_MICROS() - sensorStartMicros;
+		sensorsRead++;
+	}
+
+	// Keep the position, the next update() resumes from the following sensor
+	if (_readIndex < _sensorsCount)
+		return;
+
+	_readIndex = 0;
+	_lastReadingMillis = NBD_MILLIS();
+	_currentState = waitingNextReading;
+	_cycleCount++;
+	if (_snapshot)
+		_snapshot->publish(_temperatures, _validMask, _sensorsCount);
+
+	// One call for the whole cycle, the sensors not read keep their last valid value with the valid bit clear
+	if (cb_onCycleComplete)
+		(*cb_onCycleComplete)(_temperatures, _sensorsCount, _validMask, _changedMask);
+
+	// A cached table failing its first readout is searched again, by the discovery when available
+	if (_cacheUnverified)
+	{
+		_cacheUnverified = false;
+		if (_cacheFailed && (_oneWire == NULL || _discoveryBits == 0))
+			begin(_resolution, _tempInterval);
+	}
+}
+
+/**
+ * Runs a few bits of the 1-Wire search algorithm (Maxim application note 187) on each call.
+ * Between two bits the bus stays idle, so a pass can be spread over several update() calls
+ * as long as no other command is sent meanwhile.
+ */
+void NonBlockingDallasBase::discoverStep()
 {
-	if (_lastReadingMillis != 0 && (millis() - _lastReadingMillis < _tempInterval - _conversionMillis))
+	if (_oneWire == NULL || _discoveryBits == 0)
+		return;
+
+	if (!_sweepRunning)
+	{
+		if (NBD_MILLIS() - _lastSweepMillis < _discoveryInterval)
+			return;
+		_sweepRunning = true;
+		_lastSweepMillis = NBD_MILLIS();
+		_sweepDevices = 0;
+		_searchBit = 0;
+		_searchLastDiscrepancy = 0;
+		for (int i = 0; i < _sensorsCount; i++)
+			_sensorFlags[i] &= ~flagSeen;
+	}
+
+	if (_searchBit == 0)
+	{
+		if (!busSearchReset())
+		{
+			// No presence pulse, the bus is empty
+			finishSweep();
+			return;
+		}
+		_searchLastZero = 0;
+	}
+
+	for (uint8_t n = 0; n < _discoveryBits && _searchBit < 64; n++)
+	{
+		uint8_t bits = busSearchBits();
+		uint8_t idBit = bits & 1;
+		uint8_t cmpIdBit = bits >> 1;
+		uint8_t bitNumber = _searchBit + 1;
+		uint8_t byteMask = 1 << (_searchBit & 7);
+		uint8_t direction;
+
+		if (idBit && cmpIdBit)
+		{
+			// Nobody answered: the bus is empty, or devices left during the pass and the sweep starts over
+			if (_searchBit == 0)
+				finishSweep();
+			else
+			{
+				_sweepRunning = false;
+				_lastSweepMillis -= _discoveryInterval;
+			}
+			_searchBit = 0;
+			return;
+		}
+
+		if (idBit != cmpIdBit)
+			direction = idBit;
+		else
+		{
+			// Discrepancy: repeat the previous choice before the last discrepancy, take 1 on it, 0 after it
+			if (bitNumber < _searchLastDiscrepancy)
+				direction = (_searchAddress[_searchBit >> 3] & byteMask) ? 1 : 0;
+			else
+				direction = (bitNumber == _searchLastDiscrepancy) ? 1 : 0;
+			if (direction == 0)
+				_searchLastZero = bitNumber;
+		}
+
+		if (direction)
+			_searchAddress[_searchBit >> 3] |= byteMask;
+		else
+			_searchAddress[_searchBit >> 3] &= ~byteMask;
+
+		busSearchDirection(direction);
+		_searchBit++;
+	}
+
+	if (_searchBit < 64)
 		return;
-	requestTemperature();
+
+	_searchBit = 0;
+	_searchLastDiscrepancy = _searchLastZero;
+	if (OneWire::crc8(_searchAddress, 7) == _searchAddress[7])
+	{
+		if (_sweepDevices < 255)
+			_sweepDevices++;
+		addDiscoveredDevice(_searchAddress);
+	}
+
+	if (_searchLastDiscrepancy == 0)
+		finishSweep();
 }
 
-void NonBlockingDallas::waitConversion()
+void NonBlockingDallasBase::addDiscoveredDevice(DeviceAddress deviceAddress)
 {
-	if (_dallasTemp->isConversionComplete())
+	if (!_dallasTemp->validFamily(deviceAddress))
+		return;
+
+	int8_t deviceIndex = this->getIndex(deviceAddress);
+	if (deviceIndex >= 0)
+	{
+		_sensorFlags[deviceIndex] |= flagSeen;
+		return;
+	}
+
+	if (_sensorsCount >= _capacity)
+		return;
+
+	// New devices are appended, indexes of the known ones never change
+	deviceIndex = _sensorsCount;
+	for (size_t i = 0; i < 8; i++)
+		_sensorAddresses[deviceIndex][i] = deviceAddress[i];
+	_temperatures[deviceIndex] = DEVICE_DISCONNECTED_RAW;
+	if (_changeFilter)
+		_changeFilter->reset(deviceIndex);
+	_sensorDueMillis[deviceIndex] = NBD_MILLIS();
+	_sensorFlags[deviceIndex] = flagSeen | flagAlarmDirty;
+	if (_timings)
+		_timings->clear(deviceIndex);
+	addToAddressLookup(deviceIndex);
+	_sensorsCount++;
+	busSetResolution(deviceIndex, (uint8_t)_resolution);
+	if (_adaptive)
 	{
-		// Save the actual sensor conversion time to precisely calculate the next reading time
-		_conversionMillis = millis() - _startConversionMillis;
-		_currentState = readingSensor;
+		_adaptive->setResolution(deviceIndex, (uint8_t)_resolution);
+		_adaptive->setHold(deviceIndex, 0);
 	}
+	if (_conversionTimes)
+		_conversionTimes->reset(deviceIndex);
+
+#ifdef DEBUG_DS18B20
+	Serial.print("DS18B20: new sensor found, index ");
+	Serial.println(deviceIndex);
+#endif
 }
 
-void NonBlockingDallas::readSensors()
+void NonBlockingDallasBase::finishSweep()
 {
+	// Any other device on the bus, whatever its family, would answer to Skip ROM too
+	_singleDevice = _sweepDevices == 1 && _sensorsCount == 1 && (_sensorFlags[0] & flagSeen);
+
 	for (int i = 0; i < _sensorsCount; i++)
 	{
-		readTemperatures(i);
+		if (_sensorFlags[i] & flagSeen)
+			_sensorFlags[i] &= ~(flagSeen | flagMissing);
+		else
+			_sensorFlags[i] |= flagMissing;
 	}
+	_sweepRunning = false;
+	_searchBit = 0;
+	_searchLastDiscrepancy = 0;
+}
 
-	_lastReadingMillis = millis();
-	_currentState = waitingNextReading;
+void NonBlockingDallasBase::clearAddressLookup()
+{
+	_tableGeneration++;
+	for (uint16_t i = 0; i <= _lookupMask; i++)
+		_addressLookup[i] = 0;
+}
+
+// The CRC byte spreads well over the table, the family byte is the same for all the sensors
+uint8_t NonBlockingDallasBase::addressLookupSlot(const DeviceAddress deviceAddress)
+{
+	return (deviceAddress[7] ^ deviceAddress[1]) & _lookupMask;
+}
+
+void NonBlockingDallasBase::addToAddressLookup(uint8_t deviceIndex)
+{
+	uint8_t slot = addressLookupSlot(_sensorAddresses[deviceIndex]);
+	while (_addressLookup[slot] != 0)
+		slot = (slot + 1) & _lookupMask;
+	_addressLookup[slot] = deviceIndex + 1;
+	_tableGeneration++;
+}
+
+// Indexes never change while the table only grows, the generation changes on any edit
+void NonBlockingDallasBase::resolveQuery(NonBlockingDallasQuery &query)
+{
+	if (query._resolvedBy == this && query._resolvedGeneration == _tableGeneration)
+		return;
+
+	query._found = 0;
+	for (uint8_t i = 0; i < query._count; i++)
+	{
+		query._indexes[i] = getIndex(query._addresses[i]);
+		if (query._indexes[i] >= 0)
+			query._found++;
+	}
+	query._resolvedBy = this;
+	query._resolvedGeneration = _tableGeneration;
 }
 
-void NonBlockingDallas::readTemperatures(int deviceIndex)
+void NonBlockingDallasBase::readTemperatures(int deviceIndex)
 {
-	int32_t rawTemp = _dallasTemp->getTemp(_sensorAddresses[deviceIndex]);
+	unsigned long readMillis = NBD_MILLIS();
+	if (_timings)
+		_timings->recordRead(deviceIndex, readMillis);
+	int32_t rawTemp = readTemperatureRAW(deviceIndex);
 
 	if (rawTemp == DEVICE_DISCONNECTED_RAW)
 	{
-		if (cb_onDeviceDisconnected)
-			(*cb_onDeviceDisconnected)(deviceIndex);
+		if (_cacheUnverified)
+			_cacheFailed = true;
+		if (_stats)
+			countFailure(deviceIndex);
+		emitEvent(NonBlockingDallasEventQueue::deviceDisconnected, deviceIndex, rawTemp);
 		return;
 	}
 
+	if (_stats)
+	{
+		// Measured from the conversion request of the cycle, as the timings do
+		unsigned long conversionMillis = readMillis - _startConversionMillis;
+		_stats->recordRead(deviceIndex, conversionMillis < 0xFFFF ? conversionMillis : 0xFFFF);
+	}
+	_validMask[deviceIndex >> 3] |= 1 << (deviceIndex & 7);
+	if (_history)
+		_history->push(deviceIndex, rawTemp, NBD_MILLIS());
+
 	// Invoked only if reading is valid.
-	if (cb_onIntervalElapsed)
-		(*cb_onIntervalElapsed)(deviceIndex, rawTemp);
+	emitEvent(NonBlockingDallasEventQueue::intervalElapsed, deviceIndex, rawTemp);
 
-	if (_temperatures[deviceIndex] != rawTemp)
+	adaptInterval(deviceIndex, rawTemp);
+	adaptResolution(deviceIndex, rawTemp);
+	bool changed = filterChange(deviceIndex, rawTemp);
+	_temperatures[deviceIndex] = rawTemp;
+	if (changed)
 	{
-		_temperatures[deviceIndex] = rawTemp;
+		_changedMask[deviceIndex >> 3] |= 1 << (deviceIndex & 7);
 		// Invoked only if reading is valid.
-		if (cb_onTemperatureChange)
-			(*cb_onTemperatureChange)(deviceIndex, rawTemp);
+		emitEvent(NonBlockingDallasEventQueue::temperatureChange, deviceIndex, rawTemp);
 	}
 
 #ifdef DEBUG_DS18B20
@@ -150,12 +871,689 @@ void NonBlockingDallas::readTemperatures(int deviceIndex)
 #endif
 }
 
+// Called before the reading is stored. Without a filter for the sensor any change of the RAW value is reported,
+// the first valid reading included
+bool NonBlockingDallasBase::filterChange(uint8_t deviceIndex, int32_t rawTemp)
+{
+	if (!_changeFilter || deviceIndex >= _changeFilter->getSensors())
+		return rawTemp != _temperatures[deviceIndex];
+	return _changeFilter->filter(deviceIndex, rawTemp, NBD_MILLIS(), _minChangeInterval);
+}
+
+unsigned long NonBlockingDallasBase::effectiveInterval(uint8_t deviceIndex)
+{
+	if (_sensorIntervals[deviceIndex] > 0)
+		return _sensorIntervals[deviceIndex];
+	if (_adaptiveMinInterval > 0 && _adaptive && _adaptive->getInterval(deviceIndex) > 0)
+		return _adaptive->getInterval(deviceIndex);
+	return _tempInterval;
+}
+
+/**
+ * Stretches the interval by half while the readings are stable. When the temperature moves, the interval
+ * shrinks so that the next reading moves by about the stable change, and so that a threshold cannot be
+ * crossed before two more readings. Near a threshold the shortest interval is used
+ */
+void NonBlockingDallasBase::adaptInterval(uint8_t deviceIndex, int32_t rawTemp)
+{
+	if (_adaptiveMinInterval == 0 || !_adaptive || deviceIndex >= _adaptive->getSensors() || _sensorIntervals[deviceIndex] > 0)
+		return;
+
+	unsigned long previous = effectiveInterval(deviceIndex);
+	unsigned long interval = previous;
+	int32_t lastRAW = _temperatures[deviceIndex];
+	int32_t delta = 0;
+
+	if (lastRAW != DEVICE_DISCONNECTED_RAW)
+		delta = rawTemp > lastRAW ? rawTemp - lastRAW : lastRAW - rawTemp;
+
+	if (delta <= _adaptiveStable)
+		interval += interval / 2;
+	else if (_adaptiveStable > 0)
+		interval = interval / delta * _adaptiveStable + interval % delta * _adaptiveStable / delta;
+	else
+		interval /= 2;
+
+	int16_t low, high;
+	sensorThresholds(deviceIndex, low, high);
+	bool hasLow = low != INT16_MIN;
+	bool hasHigh = high != INT16_MAX;
+	if ((hasLow && rawTemp - low <= _adaptiveMargin) ||
+		(hasHigh && high - rawTemp <= _adaptiveMargin))
+		interval = _adaptiveMinInterval;
+	else if (delta > 0 && ((hasHigh && rawTemp > lastRAW) || (hasLow && rawTemp < lastRAW)))
+	{
+		// Readings left before the threshold is reached at the current rate
+		unsigned long readings = (rawTemp > lastRAW ? high - rawTemp : rawTemp - low) / delta;
+		if (readings < 2)
+			interval = _adaptiveMinInterval;
+		else if (interval / readings > previous / 2)
+			interval = previous / 2 * readings;
+	}
+
+	if (interval < _adaptiveMinInterval)
+		interval = _adaptiveMinInterval;
+	if (interval > _adaptiveMaxInterval)
+		interval = _adaptiveMaxInterval;
+
+	// The next conversion was scheduled with the previous interval
+	_adaptive->setInterval(deviceIndex, interval);
+	_sensorDueMillis[deviceIndex] += interval - previous;
+}
+
+/**
+ * Chooses the near resolution within the configured distance of a threshold and goes back to the far one
+ * only half that distance further, so that a temperature sitting on the boundary does not switch every reading.
+ * The near resolution is also kept for ADAPTIVE_RESOLUTION_HOLD readings, each switch writes the scratchpad
+ */
+void NonBlockingDallasBase::adaptResolution(uint8_t deviceIndex, int32_t rawTemp)
+{
+	// Without the adaptive state the sensors keep the begin() resolution
+	if (!_adaptive || deviceIndex >= _adaptive->getSensors())
+		return;
+	uint8_t current = _adaptive->getResolution(deviceIndex);
+
+	// Disabled, the resolutions are left alone unless the mode has just been turned off
+	if (_nearResolutionRAW == 0)
+	{
+		if (_restoreResolution && current != (uint8_t)_resolution)
+			applyResolution(deviceIndex, (uint8_t)_resolution);
+		return;
+	}
+
+	int16_t low, high;
+	sensorThresholds(deviceIndex, low, high);
+	int32_t distance = INT32_MAX;
+	if (low != INT16_MIN)
+		distance = rawTemp - low;
+	if (high != INT16_MAX && high - rawTemp < distance)
+		distance = high - rawTemp;
+
+	bool isNear = current == (uint8_t)_nearResolution;
+	int32_t limit = isNear ? _nearResolutionRAW + _nearResolutionRAW / 2 : _nearResolutionRAW;
+	uint8_t bits = distance <= limit ? (uint8_t)_nearResolution : (uint8_t)_farResolution;
+
+	if (bits == (uint8_t)_nearResolution)
+		_adaptive->setHold(deviceIndex, ADAPTIVE_RESOLUTION_HOLD);
+	else if (_adaptive->getHold(deviceIndex) > 0)
+	{
+		_adaptive->setHold(deviceIndex, _adaptive->getHold(deviceIndex) - 1);
+		return;
+	}
+
+	if (bits != current)
+		applyResolution(deviceIndex, bits);
+}
+
+// DallasTemperature 3.9 and later can write the scratchpad without copying it to the EEPROM,
+// which wears the EEPROM and blocks for 20 ms. Older versions always copy it
+template <class DALLAS>
+static auto disableAutoSave(DALLAS *dallasTemp, int) -> decltype(dallasTemp->getAutoSaveScratchPad())
+{
+	bool autoSave = dallasTemp->getAutoSaveScratchPad();
+	dallasTemp->setAutoSaveScratchPad(false);
+	return autoSave;
+}
+
+template <class DALLAS>
+static bool disableAutoSave(DALLAS *, long)
+{
+	return true;
+}
+
+template <class DALLAS>
+static auto restoreAutoSave(DALLAS *dallasTemp, bool autoSave, int) -> decltype(dallasTemp->setAutoSaveScratchPad(autoSave))
+{
+	dallasTemp->setAutoSaveScratchPad(autoSave);
+}
+
+template <class DALLAS>
+static void restoreAutoSave(DALLAS *, bool, long)
+{
+}
+
+void NonBlockingDallasBase::applyResolution(uint8_t deviceIndex, uint8_t bits)
+{
+	// The bus is idle during the readout, the new resolution applies from the next conversion.
+	// The sensors keep the begin() resolution in the EEPROM and restart with it after a power loss
+	bool autoSave = disableAutoSave(_dallasTemp, 0);
+	bool done = busSetResolution(deviceIndex, bits);
+	restoreAutoSave(_dallasTemp, autoSave, 0);
+	if (!done)
+		return;
+	_adaptive->setResolution(deviceIndex, bits);
+
+#ifdef DEBUG_DS18B20
+	Serial.print("DS18B20: sensor ");
+	Serial.print(deviceIndex);
+	Serial.print(" resolution set to ");
+	Serial.println(bits);
+#endif
+}
+
+/**
+ * Writes TH/TL of the first sensor waiting for it. A sensor alarms when the integer part of its temperature
+ * is greater or equal to TH or lower or equal to TL, so the thresholds are rounded down to whole degrees:
+ * any reading out of them alarms, a reading within the same degree of a threshold may alarm too
+ */
+bool NonBlockingDallasBase::programAlarms()
+{
+	for (int i = 0; i < _sensorsCount; i++)
+	{
+		if (!(_sensorFlags[i] & flagAlarmDirty))
+			continue;
+		_sensorFlags[i] &= ~flagAlarmDirty;
+		if (_sensorFlags[i] & flagMissing)
+			continue;
+
+		int16_t lowRAW, highRAW;
+		sensorThresholds(i, lowRAW, highRAW);
+		int32_t high = 125;
+		int32_t low = -55;
+		if (highRAW != INT16_MAX)
+			high = highRAW >= 0 ? highRAW / 128 : -((127 - highRAW) / 128);
+		if (lowRAW != INT16_MIN)
+			low = lowRAW >= 0 ? lowRAW / 128 : -((127 - lowRAW) / 128);
+		_searchBit = 0; // The write ends a discovery pass paused mid-ROM, the next discoverStep() starts it over
+		busSetAlarms(i, (int8_t)constrain(high, -55, 125), (int8_t)constrain(low, -55, 125));
+		return true;
+	}
+	return false;
+}
+
+/**
+ * One ROM search per call, the sensors found are kept pending, the others are not read
+ */
+void NonBlockingDallasBase::searchAlarms()
+{
+	DeviceAddress deviceAddress;
+	if (busAlarmSearch(deviceAddress))
+	{
+		int8_t deviceIndex = getIndex(deviceAddress);
+		if (deviceIndex >= 0)
+			_sensorFlags[deviceIndex] |= flagAlarmed;
+		return;
+	}
+
+	for (int i = 0; i < _sensorsCount; i++)
+	{
+		if (!(_sensorFlags[i] & flagAlarmed))
+			_sensorFlags[i] &= ~flagPending;
+	}
+	_currentState = readingSensor;
+}
+
+/**
+ * Only the sensors at the finest resolution of the conversion measured its end. A shorter time is taken at once,
+ * a longer one is approached by a quarter, so that a late update() call does not inflate the learned time
+ */
+void NonBlockingDallasBase::learnConversion(unsigned long measuredMillis)
+{
+	if (!_conversionTimes)
+		return;
+	if (measuredMillis < 1)
+		measuredMillis = 1;
+
+	for (int i = 0; i < _sensorsCount; i++)
+	{
+		if (!(_sensorFlags[i] & flagPending) || sensorResolution(i) != _cycleResolution)
+			continue;
+
+		unsigned long learned = sensorConversionMillis(i, _cycleResolution);
+		if (measuredMillis < learned)
+			learned = measuredMillis;
+		else
+			learned += (measuredMillis - learned + 3) / 4;
+		if (learned > resolutionMillis(_cycleResolution))
+			learned = resolutionMillis(_cycleResolution);
+		_conversionTimes->setMillis(i, _cycleResolution, learned);
+	}
+}
+
+/**
+ * The fast read stops after the two temperature bytes of the scratchpad and resets the bus, so nothing checks
+ * them. A value out of the sensor range, the 85 °C power-on value, an idle bus or a jump larger than the limit
+ * is read again through getTemp(), which checks the CRC of the whole scratchpad
+ */
+int32_t NonBlockingDallasBase::readTemperatureRAW(uint8_t deviceIndex)
+{
+	const uint8_t *deviceAddress = _sensorAddresses[deviceIndex];
+
+	// DS18S20 and MAX31850 use other temperature formats
+	bool fastRead = _fullReadCycles > 0 && _fastReadCycle > 0 && _oneWire != NULL &&
+					(deviceAddress[0] == DS18B20MODEL || deviceAddress[0] == DS1822MODEL);
+	int32_t rawTemp;
+	if (!fastRead || !busReadFast(deviceIndex, rawTemp))
+		return busGetTemp(deviceIndex);
+
+	int32_t lastRAW = _temperatures[deviceIndex];
+	bool plausible = rawTemp != -1 * 8 && rawTemp != 85 * 128 && rawTemp >= -55 * 128 && rawTemp <= 125 * 128; // -1: idle bus
+	if (plausible && _maxJump > 0 && lastRAW != DEVICE_DISCONNECTED_RAW)
+		plausible = (rawTemp > lastRAW ? rawTemp - lastRAW : lastRAW - rawTemp) <= _maxJump;
+
+	if (!plausible)
+		return busGetTemp(deviceIndex);
+	return rawTemp;
+}
+
+/**
+ * getTemp() does not tell a missing sensor from a corrupted scratchpad, the scratchpad is read again to find out.
+ * A bus left high answers with all ones, anything else is a sensor answering with a wrong CRC
+ */
+void NonBlockingDallasBase::countFailure(uint8_t deviceIndex)
+{
+	ScratchPad scratchPad;
+	bool answered = false;
+
+	if (busReadScratchPad(deviceIndex, scratchPad))
+	{
+		for (uint8_t i = 0; i < 9; i++)
+		{
+			if (scratchPad[i] != 0xFF && scratchPad[i] != 0x00)
+				answered = true;
+		}
+	}
+
+	_stats->recordFailure(deviceIndex, answered);
+}
+
+void NonBlockingDallasBase::validateInterval()
+{
+	if ((_tempInterval < _conversionMillis) || (_tempInterval > 4294967295UL))
+	{
+		_tempInterval = DEFAULT_INTERVAL;
+
+#ifdef DEBUG_DS18B20
+		Serial.print("DS18B20: temperature interval not valid. Setting the default value: ");
+		Serial.println(DEFAULT_INTERVAL);
+#endif
+	}
+}
+
+bool NonBlockingDallasBase::replaying()
+{
+	return _trace != NULL && _trace->getMode() == NonBlockingDallasTrace::replaying;
+}
+
+void NonBlockingDallasBase::traceOperation(uint8_t op, bool result, unsigned long startMicros, uint8_t deviceIndex, int32_t value, const uint8_t *data, uint8_t dataLength)
+{
+	if (_trace == NULL || _trace->getMode() != NonBlockingDallasTrace::recording)
+		return;
+
+	NonBlockingDallasTrace::record r;
+	r.op = op;
+	r.result = result;
+	r.deviceIndex = deviceIndex;
+	r.startMicros = startMicros;
+	r.durationMicros = NBD_MICROS() - startMicros;
+	r.value = value;
+	r.dataLength = dataLength;
+	for (uint8_t i = 0; i < dataLength; i++)
+		r.data[i] = data[i];
+	_trace->add(r);
+}
+
+uint8_t NonBlockingDallasBase::busEnumerate()
+{
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+		return _trace->find(NonBlockingDallasTrace::opEnumerate, 0xFF, r, NBD_MICROS()) ? r.value : 0;
+
+	unsigned long startMicros = NBD_MICROS();
+	_dallasTemp->begin();
+	uint8_t count = _dallasTemp->getDeviceCount();
+	traceOperation(NonBlockingDallasTrace::opEnumerate, _dallasTemp->isParasitePowerMode(), startMicros, 0xFF, count);
+	return count;
+}
+
+bool NonBlockingDallasBase::busGetAddress(uint8_t deviceIndex, DeviceAddress deviceAddress)
+{
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+	{
+		if (!_trace->find(NonBlockingDallasTrace::opAddress, deviceIndex, r, NBD_MICROS()) || !r.result)
+			return false;
+		for (uint8_t i = 0; i < 8; i++)
+			deviceAddress[i] = r.data[i];
+		return true;
+	}
+
+	unsigned long startMicros = NBD_MICROS();
+	bool found = _dallasTemp->getAddress(deviceAddress, deviceIndex);
+	traceOperation(NonBlockingDallasTrace::opAddress, found, startMicros, deviceIndex, 0, deviceAddress, found ? 8 : 0);
+	return found;
+}
+
+bool NonBlockingDallasBase::busReadPowerSupply()
+{
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+		return _trace->find(NonBlockingDallasTrace::opPowerSupply, 0xFF, r, NBD_MICROS()) && r.result;
+
+	unsigned long startMicros = NBD_MICROS();
+	bool parasite = _dallasTemp->readPowerSupply();
+	traceOperation(NonBlockingDallasTrace::opPowerSupply, parasite, startMicros);
+	return parasite;
+}
+
+// Not a bus operation, DallasTemperature keeps the power mode found by begin()
+bool NonBlockingDallasBase::busParasite()
+{
+	if (replaying())
+		return _trace->isParasite();
+	return _dallasTemp->isParasitePowerMode();
+}
+
+// deviceIndex 0xFF sets all the sensors
+bool NonBlockingDallasBase::busSetResolution(uint8_t deviceIndex, uint8_t bits)
+{
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+		return !_trace->find(NonBlockingDallasTrace::opResolution, deviceIndex, r, NBD_MICROS()) || r.result;
+
+	unsigned long startMicros = NBD_MICROS();
+	bool done = true;
+	if (deviceIndex == 0xFF)
+		_dallasTemp->setResolution(bits);
+	else
+		done = _dallasTemp->setResolution(_sensorAddresses[deviceIndex], bits, true);
+	traceOperation(NonBlockingDallasTrace::opResolution, done, startMicros, deviceIndex, bits);
+	return done;
+}
+
+void NonBlockingDallasBase::busSetAlarms(uint8_t deviceIndex, int8_t high, int8_t low)
+{
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+	{
+		_trace->find(NonBlockingDallasTrace::opAlarms, deviceIndex, r, NBD_MICROS());
+		return;
+	}
+
+	unsigned long startMicros = NBD_MICROS();
+	_dallasTemp->setHighAlarmTemp(_sensorAddresses[deviceIndex], high);
+	_dallasTemp->setLowAlarmTemp(_sensorAddresses[deviceIndex], low);
+	traceOperation(NonBlockingDallasTrace::opAlarms, true, startMicros, deviceIndex, ((int32_t)high << 8) | (uint8_t)low);
+}
+
+// deviceIndex 0xFF requests all the sensors
+void NonBlockingDallasBase::busRequest(uint8_t deviceIndex)
+{
+	uint8_t op = deviceIndex == 0xFF ? NonBlockingDallasTrace::opRequestAll : NonBlockingDallasTrace::opRequestOne;
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+	{
+		_trace->find(op, deviceIndex, r, NBD_MICROS());
+		return;
+	}
+
+	unsigned long startMicros = NBD_MICROS();
+	if (deviceIndex == 0xFF)
+		_dallasTemp->requestTemperatures();
+	else if (_oneWire != NULL)
+	{
+		// requestTemperaturesByAddress() reads the whole scratchpad for the resolution first
+		_oneWire->reset();
+		_oneWire->select(_sensorAddresses[deviceIndex]);
+		_oneWire->write(0x44); // Convert T, addressed requests are not used in parasite mode
+	}
+	else
+		_dallasTemp->requestTemperaturesByAddress(_sensorAddresses[deviceIndex]);
+	traceOperation(op, true, startMicros, deviceIndex);
+}
+
+bool NonBlockingDallasBase::busConversionComplete()
+{
+	if (replaying())
+		return _trace->replayConversion(NBD_MICROS());
+
+	unsigned long startMicros = NBD_MICROS();
+	bool complete = _dallasTemp->isConversionComplete();
+	if (_trace != NULL)
+		_trace->addPoll(complete, startMicros, NBD_MICROS() - startMicros);
+	return complete;
+}
+
+int32_t NonBlockingDallasBase::busGetTemp(uint8_t deviceIndex)
+{
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+	{
+		if (!_trace->find(NonBlockingDallasTrace::opRead, deviceIndex, r, NBD_MICROS()))
+			return DEVICE_DISCONNECTED_RAW;
+		// A fast read of the trace answers for the full read, without its CRC check
+		if (r.op == NonBlockingDallasTrace::opReadFast)
+			return r.result && r.value != -1 ? r.value * 8 : DEVICE_DISCONNECTED_RAW;
+		return r.value;
+	}
+
+	unsigned long startMicros = NBD_MICROS();
+	int32_t rawTemp = DEVICE_DISCONNECTED_RAW;
+	bool valid = false;
+	if (useSkipRom(deviceIndex))
+	{
+		ScratchPad scratchPad;
+		if (_oneWire->reset())
+		{
+			_oneWire->skip();
+			_oneWire->write(0xBE); // Read scratchpad
+			for (uint8_t i = 0; i < 9; i++)
+			{
+				scratchPad[i] = _oneWire->read();
+				if (scratchPad[i] != 0)
+					valid = true;
+			}
+			valid = valid && _oneWire->reset() && OneWire::crc8(scratchPad, 8) == scratchPad[8];
+		}
+		if (valid)
+			rawTemp = scratchPadRAW(scratchPad);
+		else
+			_singleDevice = false; // Maybe another device answering too, addressed again until the next enumeration
+	}
+	if (!valid)
+		rawTemp = _dallasTemp->getTemp(_sensorAddresses[deviceIndex]);
+	traceOperation(NonBlockingDallasTrace::opRead, true, startMicros, deviceIndex, rawTemp);
+	return rawTemp;
+}
+
+/**
+ * Reads the two temperature bytes of the scratchpad and ends the read with a reset
+ * @return false if no sensor answered the reset
+ */
+bool NonBlockingDallasBase::busReadFast(uint8_t deviceIndex, int32_t &rawTemp)
+{
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+	{
+		if (!_trace->find(NonBlockingDallasTrace::opReadFast, deviceIndex, r, NBD_MICROS()) || !r.result)
+			return false;
+		rawTemp = r.value * 8;
+		return true;
+	}
+
+	unsigned long startMicros = NBD_MICROS();
+	bool presence = _oneWire->reset();
+	uint8_t scratchPad[2] = {0xFF, 0xFF};
+	if (presence)
+	{
+		if (useSkipRom(deviceIndex))
+			_oneWire->skip();
+		else
+			_oneWire->select(_sensorAddresses[deviceIndex]);
+		_oneWire->write(0xBE); // Read scratchpad
+		scratchPad[0] = _oneWire->read();
+		scratchPad[1] = _oneWire->read();
+		_oneWire->reset(); // Ends the read, the other bytes are not sent
+	}
+	rawTemp = scratchPadRAW(scratchPad);
+	traceOperation(NonBlockingDallasTrace::opReadFast, presence, startMicros, deviceIndex, rawTemp / 8); // Recorded as the register
+	return presence;
+}
+
+// Temperature register of the first two scratchpad bytes, sign extended, from 1/16 °C to 1/128 °C
+int32_t NonBlockingDallasBase::scratchPadRAW(const uint8_t *scratchPad)
+{
+	return (int32_t)(int16_t)((scratchPad[1] << 8) | scratchPad[0]) * 8;
+}
+
+bool NonBlockingDallasBase::busReadScratchPad(uint8_t deviceIndex, ScratchPad scratchPad)
+{
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+	{
+		if (!_trace->find(NonBlockingDallasTrace::opScratchPad, deviceIndex, r, NBD_MICROS()) || !r.result)
+			return false;
+		for (uint8_t i = 0; i < 9; i++)
+			scratchPad[i] = r.data[i];
+		return true;
+	}
+
+	unsigned long startMicros = NBD_MICROS();
+	bool read = _dallasTemp->readScratchPad(_sensorAddresses[deviceIndex], scratchPad);
+	traceOperation(NonBlockingDallasTrace::opScratchPad, read, startMicros, deviceIndex, 0, scratchPad, read ? 9 : 0);
+	return read;
+}
+
+/**
+ * Skip ROM saves the 64 bits of Match ROM, only with one device on the bus: a second one would answer at
+ * the same time. The full reads check the CRC, which fails when two devices answer together
+ */
+bool NonBlockingDallasBase::useSkipRom(uint8_t deviceIndex)
+{
+	const uint8_t *deviceAddress = _sensorAddresses[deviceIndex];
+	return _skipRom && _singleDevice && _sensorsCount == 1 && _oneWire != NULL &&
+		   (deviceAddress[0] == DS18B20MODEL || deviceAddress[0] == DS1822MODEL);
+}
+
+// Not a bus operation, the next alarmSearch() starts a new pass
+void NonBlockingDallasBase::busResetAlarmSearch()
+{
+	if (!replaying())
+		_dallasTemp->resetAlarmSearch();
+}
+
+bool NonBlockingDallasBase::busAlarmSearch(DeviceAddress deviceAddress)
+{
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+	{
+		if (!_trace->find(NonBlockingDallasTrace::opAlarmSearch, 0xFF, r, NBD_MICROS()) || !r.result)
+			return false;
+		for (uint8_t i = 0; i < 8; i++)
+			deviceAddress[i] = r.data[i];
+		return true;
+	}
+
+	unsigned long startMicros = NBD_MICROS();
+	bool found = _dallasTemp->alarmSearch(deviceAddress);
+	traceOperation(NonBlockingDallasTrace::opAlarmSearch, found, startMicros, 0xFF, 0, deviceAddress, found ? 8 : 0);
+	return found;
+}
+
+/**
+ * Starts a discovery pass with the Search ROM command
+ * @return false if no sensor answered the reset
+ */
+bool NonBlockingDallasBase::busSearchReset()
+{
+	NonBlockingDallasTrace::record r;
+	if (replaying())
+		return _trace->find(NonBlockingDallasTrace::opSearchReset, 0xFF, r, NBD_MICROS()) && r.result;
+
+	unsigned long startMicros = NBD_MICROS();
+	bool presence = _oneWire->reset();
+	if (presence)
+		_oneWire->write(0xF0); // Search ROM
+	traceOperation(NonBlockingDallasTrace::opSearchReset, presence, startMicros);
+	return presence;
+}
+
+// Id bit in bit 0, complement bit in bit 1
+uint8_t NonBlockingDallasBase::busSearchBits()
+{
+	if (replaying())
+		return _trace->replaySearchBits(NBD_MICROS());
+
+	unsigned long startMicros = NBD_MICROS();
+	uint8_t bits = _oneWire->read_bit();
+	bits |= _oneWire->read_bit() << 1;
+	if (_trace != NULL)
+		_trace->addSearchBits(bits, startMicros, NBD_MICROS() - startMicros);
+	return bits;
+}
+
+void NonBlockingDallasBase::busSearchDirection(uint8_t direction)
+{
+	if (!replaying())
+		_oneWire->write_bit(direction);
+}
+
+void NonBlockingDallasBase::emitEvent(uint8_t type, int deviceIndex, int32_t rawTemp)
+{
+	if (_eventQueue)
+	{
+		_eventQueue->push(type, deviceIndex + _indexOffset, rawTemp);
+		return;
+	}
+
+	switch (type)
+	{
+	case NonBlockingDallasEventQueue::intervalElapsed:
+		if (cb_onIntervalElapsed)
+			(*cb_onIntervalElapsed)(deviceIndex + _indexOffset, rawTemp);
+		break;
+	case NonBlockingDallasEventQueue::temperatureChange:
+		if (cb_onTemperatureChange)
+			(*cb_onTemperatureChange)(deviceIndex + _indexOffset, rawTemp);
+		break;
+	case NonBlockingDallasEventQueue::deviceDisconnected:
+		if (cb_onDeviceDisconnected)
+			(*cb_onDeviceDisconnected)(deviceIndex + _indexOffset);
+		break;
+	}
+}
+
+void NonBlockingDallasBase::scheduleChanged()
+{
+	if (cb_onScheduleChange)
+		(*cb_onScheduleChange)(millisToNextUpdate());
+}
+
+uint16_t NonBlockingDallasBase::resolutionMillis(uint8_t bits)
+{
+	return 750 / (1 << (12 - bits));
+}
+
+// The adaptive resolution is the only one changing the resolution of a sensor after begin()
+uint8_t NonBlockingDallasBase::sensorResolution(uint8_t deviceIndex)
+{
+	uint8_t bits = _adaptive ? _adaptive->getResolution(deviceIndex) : 0;
+	return bits > 0 ? bits : (uint8_t)_resolution;
+}
+
+uint16_t NonBlockingDallasBase::sensorConversionMillis(uint8_t deviceIndex, uint8_t bits)
+{
+	uint16_t learned = _conversionTimes ? _conversionTimes->getMillis(deviceIndex, bits) : 0;
+	return learned > 0 ? learned : resolutionMillis(bits);
+}
+
+void NonBlockingDallasBase::sensorThresholds(uint8_t deviceIndex, int16_t &lowRAW, int16_t &highRAW)
+{
+	lowRAW = INT16_MIN;
+	highRAW = INT16_MAX;
+	if (_thresholds)
+		_thresholds->getThresholds(deviceIndex, lowRAW, highRAW);
+}
+
 //==============================================================================================
 //									PUBLIC
 //==============================================================================================
 
-void NonBlockingDallas::update()
+void NonBlockingDallasBase::update()
 {
+	unsigned long startMicros = NBD_MICROS();
+	sensorState startState = _currentState;
+
 	switch (_currentState)
 	{
 	case notFound:
@@ -164,36 +1562,587 @@ void NonBlockingDallas::update()
 	case waitingNextReading:
 		waitNextReading();
 		break;
+	case requestingConversion:
+		requestSensors();
+		break;
 	case waitingConversion:
 		waitConversion();
 		break;
+	case searchingAlarms:
+		searchAlarms();
+		break;
+	case readingSensor:
+		readSensors();
+		break;
+	}
+
+	if (!_stats)
+		return;
+
+	// From the conversion request to the end of the readout the calls are spent on the bus
+	_stats->recordUpdate(NBD_MICROS() - startMicros, startState != waitingNextReading || _currentState != waitingNextReading);
+	if (startState == readingSensor && _currentState == waitingNextReading)
+		_stats->recordCycle(_conversionMillis);
+}
+
+void NonBlockingDallasBase::requestTemperature()
+{
+	uint8_t pendingCount = 0;
+	for (int i = 0; i < _sensorsCount; i++)
+	{
+		if (_sensorFlags[i] & flagMissing)
+			continue;
+		_sensorFlags[i] |= flagPending;
+		pendingCount++;
+	}
+	requestConversion(pendingCount);
+	scheduleChanged();
+}
+
+/**
+ * @brief Limit the work done by each update() call while requesting and reading the sensors
+ *
+ * The readout, and the addressed conversion requests, are spread over several update() calls keeping
+ * their position between them, so the time spent in a single call does not grow with the number of sensors.
+ *
+ * @param sensorsPerUpdate maximum number of sensors requested or read by each call, 0 for all
+ * @param budgetMicros time budget of each call [microseconds], 0 disables it. At least one sensor is always handled
+ */
+void NonBlockingDallasBase::setReadoutSlice(uint8_t sensorsPerUpdate, unsigned long budgetMicros)
+{
+	_sensorsPerUpdate = sensorsPerUpdate;
+	_readBudgetMicros = budgetMicros;
+}
+
+/**
+ * @brief Set the reading interval of a single sensor
+ *
+ * Only the sensors that are due are converted and read. Sensors sharing the same
+ * interval, or due within the merge window, are converted together.
+ *
+ * @param interval [milliseconds], 0 restores the interval passed to begin()
+ * @return false if the index does not exist or the interval is shorter than the conversion time
+ */
+bool NonBlockingDallasBase::setSensorInterval(uint8_t deviceIndex, unsigned long interval)
+{
+	if (!this->indexExist(deviceIndex) || (interval > 0 && interval < getConversionMillis(deviceIndex)))
+		return false;
+
+	// Apply the new interval from the next conversion of the sensor
+	unsigned long previous = this->getSensorInterval(deviceIndex);
+	_sensorIntervals[deviceIndex] = interval;
+	_sensorDueMillis[deviceIndex] += this->getSensorInterval(deviceIndex) - previous;
+	scheduleChanged();
+	return true;
+}
+
+/**
+ * @brief Get the reading interval of a sensor
+ *
+ * @return unsigned long interval [milliseconds], 0 if the index does not exist
+ */
+unsigned long NonBlockingDallasBase::getSensorInterval(uint8_t deviceIndex)
+{
+	if (!this->indexExist(deviceIndex))
+		return 0;
+	return effectiveInterval(deviceIndex);
+}
+
+/**
+ * @brief Set the thresholds of a sensor, used by the adaptive modes and the alarm mode
+ *
+ * Requires attachThresholds().
+ *
+ * @param lowRAW lower threshold, INT16_MIN for none
+ * @param highRAW upper threshold, INT16_MAX for none
+ * @return false without the thresholds attached, if the index does not exist or the thresholds are out of order
+ */
+bool NonBlockingDallasBase::setThresholds(uint8_t deviceIndex, int32_t lowRAW, int32_t highRAW)
+{
+	if (!_thresholds || !this->indexExist(deviceIndex) || lowRAW > highRAW || lowRAW < INT16_MIN || highRAW > INT16_MAX)
+		return false;
+	if (!_thresholds->setThresholds(deviceIndex, lowRAW, highRAW))
+		return false;
+	_sensorFlags[deviceIndex] |= flagAlarmDirty;
+	if (_alarmSweepCycles > 0)
+		scheduleChanged();
+	return true;
+}
+
+/**
+ * @brief Adapt the interval of each sensor to how fast its temperature changes
+ *
+ * The interval grows towards maxInterval while two readings differ by no more than stableRAW,
+ * and shrinks towards minInterval when the temperature moves faster or gets within marginRAW
+ * of a threshold. Sensors with their own interval set by setSensorInterval() are not adapted.
+ * Requires attachAdaptive(), and attachThresholds() for the margin.
+ *
+ * @param minInterval [milliseconds], 0 disables the adaptive mode
+ * @param maxInterval [milliseconds]
+ */
+void NonBlockingDallasBase::setAdaptiveInterval(unsigned long minInterval, unsigned long maxInterval, uint16_t stableRAW, uint16_t marginRAW)
+{
+	if (minInterval > 0 && minInterval < _conversionMillis)
+		minInterval = _conversionMillis;
+	if (maxInterval < minInterval)
+		maxInterval = minInterval;
+
+	_adaptiveMinInterval = minInterval;
+	_adaptiveMaxInterval = maxInterval;
+	_adaptiveStable = stableRAW;
+	_adaptiveMargin = marginRAW;
+	if (_adaptive)
+		_adaptive->setIntervalAll(minInterval);
+	scheduleChanged();
+}
+
+/**
+ * @brief Choose the resolution of each sensor by its distance to the thresholds set by setThresholds()
+ *
+ * Sensors within nearRAW of a threshold use nearRes, the others farRes, trading precision
+ * for a shorter conversion while the temperature is far from any threshold.
+ * The resolution is changed after a reading, when the bus is idle. Requires attachAdaptive() and attachThresholds().
+ *
+ * @param nearRAW distance to a threshold [RAW], 0 disables the mode and restores the begin() resolution
+ */
+void NonBlockingDallasBase::setAdaptiveResolution(resolution farRes, resolution nearRes, uint16_t nearRAW)
+{
+	_restoreResolution = nearRAW == 0 && (_restoreResolution || _nearResolutionRAW > 0);
+	_farResolution = farRes;
+	_nearResolution = nearRes;
+	_nearResolutionRAW = nearRAW;
+}
+
+/**
+ * @brief Read only the sensors out of their thresholds
+ *
+ * The thresholds set by setThresholds() are written to the TH/TL alarm registers of the sensors,
+ * rounded down to whole degrees. After each conversion the alarm search finds the sensors out of
+ * them, one per update() call, and only those are read. Every fullSweepCycles conversions all the
+ * sensors are read. Sensors without thresholds alarm only out of the -55..125 °C range.
+ *
+ * @param fullSweepCycles conversions among two full readouts, 0 disables the mode
+ */
+void NonBlockingDallasBase::setAlarmMode(uint8_t fullSweepCycles)
+{
+	_alarmSweepCycles = fullSweepCycles;
+	_alarmCycle = fullSweepCycles > 0 ? fullSweepCycles - 1 : 0; // The first readout is a full one
+	for (int i = 0; i < _sensorsCount; i++)
+		_sensorFlags[i] |= flagAlarmDirty;
+	scheduleChanged();
+}
+
+/**
+ * @brief Do not poll the bus before the expected end of the conversion
+ *
+ * With attachConversionTimes() the conversion time of each sensor is learned at each resolution,
+ * otherwise the datasheet time is used. Polling starts shortly before the longest time among the
+ * sensors converting and then backs off, so the bus stays quiet during the conversion. In parasite power mode the bus is never polled and
+ * the datasheet time is waited, whatever this setting.
+ */
+void NonBlockingDallasBase::setTimedWait(bool timedWait)
+{
+	_timedWait = timedWait;
+	scheduleChanged();
+}
+
+/**
+ * @brief Read only the two temperature bytes of the scratchpad
+ *
+ * Requires the OneWire instance passed to the constructor. The readout of one conversion every
+ * fullReadCycles reads and checks the CRC of the whole scratchpad, as well as any value out of
+ * the sensor range, equal to the 85 °C power-on value or moving more than maxJumpRAW.
+ * DS18S20 sensors are always read in full.
+ *
+ * @param fullReadCycles conversions among two CRC checked readouts, 0 disables the fast read
+ * @param maxJumpRAW largest change accepted without a CRC check [RAW], 0 for any
+ * @return false if the OneWire instance is not available
+ */
+bool NonBlockingDallasBase::setFastRead(uint8_t fullReadCycles, uint16_t maxJumpRAW)
+{
+	if (_oneWire == NULL)
+		return false;
+	_fullReadCycles = fullReadCycles;
+	_fastReadCycle = 0;
+	_maxJump = maxJumpRAW;
+	return true;
+}
+
+/**
+ * @brief Address the sensor with Skip ROM when it is the only device on the bus
+ *
+ * Enabled by default, requires the OneWire instance passed to the constructor. The readout skips the
+ * Match ROM when begin() or the last discovery sweep found exactly one device, the sensor of the table.
+ * A full readout failing its CRC check goes back to Match ROM until the next enumeration confirms
+ * the single device again, and a device found by the discovery stops it at once. With the fast read,
+ * a second device plugged without the discovery running is caught by the next CRC checked readout.
+ */
+void NonBlockingDallasBase::setSkipRom(bool skipRom)
+{
+	_skipRom = skipRom;
+}
+
+/**
+ * @brief The readout currently addresses the only sensor with Skip ROM
+ */
+bool NonBlockingDallasBase::isSkipRomActive()
+{
+	return _sensorsCount == 1 && useSkipRom(0);
+}
+
+/**
+ * @brief Resolution of a sensor [bits], 0 if the index does not exist
+ */
+uint8_t NonBlockingDallasBase::getSensorResolution(uint8_t deviceIndex)
+{
+	if (!this->indexExist(deviceIndex))
+		return 0;
+	return sensorResolution(deviceIndex);
+}
+
+/**
+ * @brief Conversion time of a sensor at its resolution [milliseconds], learned with attachConversionTimes()
+ * once the sensor has been the slowest of a conversion, 0 if the index does not exist
+ */
+unsigned long NonBlockingDallasBase::getConversionMillis(uint8_t deviceIndex)
+{
+	if (!this->indexExist(deviceIndex))
+		return 0;
+	return sensorConversionMillis(deviceIndex, sensorResolution(deviceIndex));
+}
+
+/**
+ * @brief Set how early a sensor may be converted to join a conversion of other sensors
+ *
+ * Defaults to the conversion time of the resolution passed to begin(), a window set before begin() is kept.
+ *
+ * @param mergeWindow [milliseconds]
+ */
+void NonBlockingDallasBase::setMergeWindow(unsigned long mergeWindow)
+{
+	_mergeWindow = mergeWindow;
+	_mergeWindowSet = true;
+	scheduleChanged();
+}
+
+/**
+ * @brief Configure the background discovery of the sensors, requires the OneWire passed to the constructor
+ *
+ * While the bus is idle, each update() call runs a few bits of the 1-Wire search. New sensors are
+ * appended to the table and sensors not found by a sweep are skipped until they come back.
+ *
+ * @param bitsPerUpdate ROM bits searched by each update() call, 0 disables the discovery
+ * @param interval time among discovery sweeps [milliseconds], the interval passed to begin() until set
+ */
+void NonBlockingDallasBase::setDiscovery(uint8_t bitsPerUpdate, unsigned long interval)
+{
+	_discoveryBits = bitsPerUpdate;
+	_discoveryInterval = interval;
+	_discoveryIntervalSet = true;
+	if (_discoveryBits == 0)
+	{
+		_sweepRunning = false;
+		_searchBit = 0;
+	}
+	scheduleChanged();
+}
+
+/**
+ * @brief Keep the history of the valid readings
+ *
+ * @param history NonBlockingDallasHistoryN instance, NULL stops recording
+ */
+void NonBlockingDallasBase::attachHistory(NonBlockingDallasHistory *history)
+{
+	_history = history;
+}
+
+/**
+ * @brief Defer the callbacks of the readout
+ *
+ * With a queue attached the readout only stores onIntervalElapsed, onTemperatureChange and
+ * onDeviceDisconnected events, and dispatch() invokes the callbacks later, so slow callbacks
+ * do not delay the bus. onCycleComplete is still invoked at the end of the readout.
+ *
+ * @param eventQueue NonBlockingDallasEventQueueN instance, NULL invokes the callbacks at once
+ */
+void NonBlockingDallasBase::attachEventQueue(NonBlockingDallasEventQueue *eventQueue)
+{
+	_eventQueue = eventQueue;
+}
+
+/**
+ * @brief Record the bus operations, or replay a recorded trace in place of the bus
+ *
+ * The trace is driven by NonBlockingDallasTrace::startRecording() and startReplay(). During the replay
+ * the bus is not used, NBD_MILLIS() and NBD_MICROS() can follow a simulated clock.
+ *
+ * @param trace NonBlockingDallasTraceN instance, NULL disables it
+ */
+void NonBlockingDallasBase::attachTrace(NonBlockingDallasTrace *trace)
+{
+	_trace = trace;
+}
+
+/**
+ * @brief Count the update() calls, the cycles and the failed readings
+ *
+ * A failed reading reads the scratchpad once more, only while the counters are attached,
+ * to tell a sensor not answering from a corrupted scratchpad.
+ *
+ * @param stats NonBlockingDallasStatsN instance, NULL disables the counters
+ */
+void NonBlockingDallasBase::attachStats(NonBlockingDallasStats *stats)
+{
+	_stats = stats;
+}
+
+/**
+ * @brief Publish the temperatures at the end of each cycle, for readers on another core or task
+ *
+ * @param snapshot NonBlockingDallasSnapshotN instance, NULL stops publishing
+ */
+void NonBlockingDallasBase::attachSnapshot(NonBlockingDallasSnapshot *snapshot)
+{
+	_snapshot = snapshot;
+}
+
+/**
+ * @brief Keep the conversion and readout time of each sensor, written by exportCycle() and getSampleTimes()
+ *
+ * @param timings NonBlockingDallasTimingsN instance, NULL disables them
+ */
+void NonBlockingDallasBase::attachTimings(NonBlockingDallasTimings *timings)
+{
+	_timings = timings;
+	if (_timings)
+		_timings->startCycle(_startConversionMillis); // The cycle in progress has no conversion times
+}
+
+/**
+ * @brief Keep the deadband, the hysteresis and the last reported value of each sensor, see setChangeFilter()
+ *
+ * Without it onTemperatureChange is invoked for any change of the RAW value.
+ *
+ * @param changeFilter NonBlockingDallasChangeFilterN instance, NULL reports any change
+ */
+void NonBlockingDallasBase::attachChangeFilter(NonBlockingDallasChangeFilter *changeFilter)
+{
+	_changeFilter = changeFilter;
+}
+
+/**
+ * @brief Keep the thresholds of each sensor, see setThresholds()
+ *
+ * @param thresholds NonBlockingDallasThresholdsN instance, NULL removes the thresholds
+ */
+void NonBlockingDallasBase::attachThresholds(NonBlockingDallasThresholds *thresholds)
+{
+	_thresholds = thresholds;
+	for (int i = 0; i < _sensorsCount; i++)
+		_sensorFlags[i] |= flagAlarmDirty;
+}
+
+/**
+ * @brief Keep the interval and the resolution of each sensor chosen by the adaptive modes,
+ * see setAdaptiveInterval() and setAdaptiveResolution()
+ *
+ * The sensors start from the shortest adaptive interval and from the begin() resolution.
+ *
+ * @param adaptive NonBlockingDallasAdaptiveN instance, NULL disables the adaptive modes
+ */
+void NonBlockingDallasBase::attachAdaptive(NonBlockingDallasAdaptive *adaptive)
+{
+	_adaptive = adaptive;
+	if (!_adaptive)
+		return;
+	_adaptive->setIntervalAll(_adaptiveMinInterval);
+	for (uint8_t i = 0; i < _adaptive->getSensors(); i++)
+	{
+		_adaptive->setResolution(i, (uint8_t)_resolution);
+		_adaptive->setHold(i, 0);
+	}
+}
+
+/**
+ * @brief Learn the conversion time of each sensor at each resolution, followed by the timed wait
+ *
+ * Without it the datasheet times are used.
+ *
+ * @param conversionTimes NonBlockingDallasConversionTimesN instance, NULL uses the datasheet times
+ */
+void NonBlockingDallasBase::attachConversionTimes(NonBlockingDallasConversionTimes *conversionTimes)
+{
+	_conversionTimes = conversionTimes;
+}
+
+/**
+ * @brief Number of conversion and readout cycles completed since the construction
+ */
+uint32_t NonBlockingDallasBase::getCycleCount()
+{
+	return _cycleCount;
+}
+
+/**
+ * @brief Invoke the callbacks of the queued events, oldest first
+ *
+ * @param maxEvents maximum number of events delivered, 0 for all
+ * @param budgetMicros time budget of the call [microseconds], 0 disables it. At least one event is delivered
+ * @return number of events delivered
+ */
+uint8_t NonBlockingDallasBase::dispatch(uint8_t maxEvents, unsigned long budgetMicros)
+{
+	if (_eventQueue == NULL)
+		return 0;
+
+	unsigned long startMicros = NBD_MICROS();
+	uint8_t delivered = 0;
+	NonBlockingDallasEventQueue::event e;
+
+	while ((maxEvents == 0 || delivered < maxEvents) && _eventQueue->pop(e))
+	{
+		switch (e.type)
+		{
+		case NonBlockingDallasEventQueue::intervalElapsed:
+			if (cb_onIntervalElapsed)
+				(*cb_onIntervalElapsed)(e.deviceIndex, e.temperatureRAW);
+			break;
+		case NonBlockingDallasEventQueue::temperatureChange:
+			if (cb_onTemperatureChange)
+				(*cb_onTemperatureChange)(e.deviceIndex, e.temperatureRAW);
+			break;
+		case NonBlockingDallasEventQueue::deviceDisconnected:
+			if (cb_onDeviceDisconnected)
+				(*cb_onDeviceDisconnected)(e.deviceIndex);
+			break;
+		}
+		delivered++;
+
+		if (budgetMicros > 0 && NBD_MICROS() - startMicros >= budgetMicros)
+			break;
+	}
+	return delivered;
+}
+
+/**
+ * @brief Filter the noise out of onTemperatureChange for a sensor
+ *
+ * The change is reported when the reading moves away from the last reported value by more than
+ * deadbandRAW. Going back in the opposite direction needs hysteresisRAW more. 0 and 0 report any change.
+ * Requires attachChangeFilter().
+ *
+ * @return false without the change filter attached or if the index does not exist
+ */
+bool NonBlockingDallasBase::setChangeFilter(uint8_t deviceIndex, uint16_t deadbandRAW, uint16_t hysteresisRAW)
+{
+	if (!_changeFilter || !this->indexExist(deviceIndex))
+		return false;
+	return _changeFilter->setFilter(deviceIndex, deadbandRAW, hysteresisRAW);
+}
+
+/**
+ * @brief Filter the noise out of onTemperatureChange for all the sensors, including the ones found later
+ *
+ * Requires attachChangeFilter().
+ */
+void NonBlockingDallasBase::setChangeFilterAll(uint16_t deadbandRAW, uint16_t hysteresisRAW)
+{
+	if (_changeFilter)
+		_changeFilter->setFilterAll(deadbandRAW, hysteresisRAW);
+}
+
+/**
+ * @brief Set the minimum time among two onTemperatureChange of the same sensor
+ *
+ * A change happening earlier is reported by the first reading after the interval, if still beyond the deadband.
+ * Requires attachChangeFilter().
+ *
+ * @param minChangeInterval [milliseconds], 0 disables it
+ */
+void NonBlockingDallasBase::setMinChangeInterval(unsigned long minChangeInterval)
+{
+	_minChangeInterval = minChangeInterval;
+}
+
+/**
+ * @brief Shift the deviceIndex passed to the callbacks
+ *
+ * Used when several buses share one index space, getters keep using the local index.
+ */
+void NonBlockingDallasBase::setIndexOffset(uint8_t indexOffset)
+{
+	_indexOffset = indexOffset;
+}
+
+/**
+ * @brief Check if the conversion is complete and the sensors are waiting to be read
+ *
+ * @return true if the next update() call reads the sensors
+ */
+bool NonBlockingDallasBase::isReadoutPending()
+{
+	return _currentState == searchingAlarms || _currentState == readingSensor;
+}
+
+/**
+ * @brief Time until update() has something to do
+ *
+ * Calls before that time return without touching the bus, so the caller can sleep meanwhile.
+ * Without setTimedWait(true) the end of a conversion is polled by each call, so 0 is returned
+ * while converting. Functions called outside update() that change the time, like requestTemperature()
+ * or setSensorInterval(), invoke the onScheduleChange() callback to wake the caller.
+ *
+ * @return unsigned long [milliseconds], 0 if update() must be called now, 0xFFFFFFFF if nothing is scheduled
+ */
+unsigned long NonBlockingDallasBase::millisToNextUpdate()
+{
+	unsigned long now = NBD_MILLIS();
+	unsigned long next = 0xFFFFFFFFUL;
+
+	switch (_currentState)
+	{
+	case notFound:
+		return next;
+	case waitingConversion:
+		if (busParasite())
+			next = _lastRequestMillis + resolutionMillis(_cycleResolution);
+		else if (_timedWait)
+			next = _nextPollMillis;
+		else
+			return 0; // Each update() polls the bus, the end of the conversion is not known in advance
+		return (long)(next - now) > 0 ? next - now : 0;
+	case requestingConversion:
+	case searchingAlarms:
 	case readingSensor:
-		readSensors();
+		return 0;
+	case waitingNextReading:
 		break;
 	}
-}
 
-void NonBlockingDallas::requestTemperature()
-{
-	_sensorsCount = _dallasTemp->getDeviceCount();
-	if (_sensorsCount < 1)
+	if (_sweepRunning)
+		return 0;
+	for (int i = 0; i < _sensorsCount; i++)
 	{
-#ifdef DEBUG_DS18B20
-		Serial.print("DS18B20: no sensors found on the bus");
-		Serial.println("");
-#endif
-
-		return;
+		if (_alarmSweepCycles > 0 && (_sensorFlags[i] & flagAlarmDirty))
+			return 0;
+		if (_sensorFlags[i] & flagMissing)
+			continue;
+		long dueIn = (long)(_sensorDueMillis[i] - now);
+		if (dueIn <= 0)
+			return 0;
+		if ((unsigned long)dueIn < next)
+			next = dueIn;
 	}
-
-	_currentState = waitingConversion;
-	_startConversionMillis = millis();
-	_dallasTemp->requestTemperatures(); // Requests a temperature conversion for all the sensors on the bus
-
-#ifdef DEBUG_DS18B20
-	Serial.print("DS18B20: requested new reading");
-	Serial.println("");
-#endif
+	if (_oneWire != NULL && _discoveryBits > 0)
+	{
+		long sweepIn = (long)(_lastSweepMillis + _discoveryInterval - now);
+		if (sweepIn <= 0)
+			return 0;
+		if ((unsigned long)sweepIn < next)
+			next = sweepIn;
+	}
+	return next;
 }
 
 /**
@@ -215,31 +2164,52 @@ void NonBlockingDallas::requestTemperature()
  *
  * @return uint8_t Number of sensors found
  */
-uint8_t NonBlockingDallas::getSensorsCount()
+uint8_t NonBlockingDallasBase::getSensorsCount()
 {
 	return this->_sensorsCount;
 }
 
+/**
+ * @brief Get the maximum number of sensors handled
+ *
+ * @return uint8_t ONE_WIRE_MAX_DEV for NonBlockingDallas, the template parameter for NonBlockingDallasN
+ */
+uint8_t NonBlockingDallasBase::getCapacity()
+{
+	return this->_capacity;
+}
+
 /**
  * @brief Validate a sensor index
  *
  * @return true if index exist
  * @return false if not exist
  */
-bool NonBlockingDallas::indexExist(uint8_t deviceIndex)
+bool NonBlockingDallasBase::indexExist(uint8_t deviceIndex)
 {
 	if (this->_sensorsCount > 0 && deviceIndex >= 0 && deviceIndex < this->_sensorsCount)
 		return true;
 	return false;
 }
 
+/**
+ * @brief Check if a sensor was found by the last discovery sweep
+ *
+ * @return true if index exist and the sensor is on the bus
+ * @return false if not exist or missing
+ */
+bool NonBlockingDallasBase::isSensorPresent(uint8_t deviceIndex)
+{
+	return this->indexExist(deviceIndex) && !(_sensorFlags[deviceIndex] & flagMissing);
+}
+
 /**
  * @brief If exist index, copie address into DeviceAddress
  *
  * @return true if index exist
  * @return false else index not exist
  */
-bool NonBlockingDallas::getDeviceAddress(uint8_t deviceIndex, DeviceAddress deviceAddress)
+bool NonBlockingDallasBase::getDeviceAddress(uint8_t deviceIndex, DeviceAddress deviceAddress)
 {
 	if (deviceIndex >= 0 && deviceIndex < this->_sensorsCount)
 	{
@@ -255,11 +2225,28 @@ bool NonBlockingDallas::getDeviceAddress(uint8_t deviceIndex, DeviceAddress devi
  *
  * @return String representation of the address
  */
-String NonBlockingDallas::getAddressString(uint8_t deviceIndex)
+String NonBlockingDallasBase::getAddressString(uint8_t deviceIndex)
 {
-	DeviceAddress tmpAddress;
-	this->getDeviceAddress(deviceIndex, tmpAddress);
-	return this->convertDeviceAddressToString(tmpAddress);
+	char addressString[17];
+	this->getAddressString(deviceIndex, addressString);
+	return String(addressString);
+}
+
+/**
+ * @brief Write the address string representation from index into a caller buffer
+ *
+ * @return true if index exist
+ * @return false if not exist, addressString is then empty
+ */
+bool NonBlockingDallasBase::getAddressString(uint8_t deviceIndex, char addressString[17])
+{
+	if (!this->indexExist(deviceIndex))
+	{
+		addressString[0] = '\0';
+		return false;
+	}
+	formatAddress(this->_sensorAddresses[deviceIndex], addressString);
+	return true;
 }
 
 /**
@@ -268,7 +2255,7 @@ String NonBlockingDallas::getAddressString(uint8_t deviceIndex)
  * @return int32_t temperature IF index exist
  * @return DEVICE_DISCONNECTED_RAW if index not exist
  */
-int32_t NonBlockingDallas::getTemperatureRAW(uint8_t deviceIndex)
+int32_t NonBlockingDallasBase::getTemperatureRAW(uint8_t deviceIndex)
 {
 	if (this->indexExist(deviceIndex))
 		return this->_temperatures[deviceIndex];
@@ -282,7 +2269,7 @@ int32_t NonBlockingDallas::getTemperatureRAW(uint8_t deviceIndex)
  * @return float temperature IF index exist
  * @return DEVICE_DISCONNECTED_C if index not exist
  */
-float NonBlockingDallas::getTemperatureC(uint8_t deviceIndex)
+float NonBlockingDallasBase::getTemperatureC(uint8_t deviceIndex)
 {
 	if (this->indexExist(deviceIndex))
 		return this->rawToCelsius(this->_temperatures[deviceIndex]);
@@ -296,7 +2283,7 @@ float NonBlockingDallas::getTemperatureC(uint8_t deviceIndex)
  * @return float temperature IF index exist
  * @return DEVICE_DISCONNECTED_F if index not exist
  */
-float NonBlockingDallas::getTemperatureF(uint8_t deviceIndex)
+float NonBlockingDallasBase::getTemperatureF(uint8_t deviceIndex)
 {
 	if (this->indexExist(deviceIndex))
 		return this->rawToFahrenheit(this->_temperatures[deviceIndex]);
@@ -304,6 +2291,112 @@ float NonBlockingDallas::getTemperatureF(uint8_t deviceIndex)
 		return DEVICE_DISCONNECTED_F;
 }
 
+/**
+ * @brief Get Temperature from sensor index in hundredths of °C, without floating point
+ *
+ * @return int32_t temperature IF index exist
+ * @return DEVICE_DISCONNECTED_C * 100 if index not exist
+ */
+int32_t NonBlockingDallasBase::getTemperatureCentiC(uint8_t deviceIndex)
+{
+	if (this->indexExist(deviceIndex))
+		return rawToCentiCelsius(this->_temperatures[deviceIndex]);
+	else
+		return DEVICE_DISCONNECTED_C * 100;
+}
+
+/**
+ * @brief Get Temperature from sensor index in hundredths of °F, without floating point
+ *
+ * @return int32_t temperature IF index exist
+ * @return DEVICE_DISCONNECTED_F * 100 if index not exist
+ */
+int32_t NonBlockingDallasBase::getTemperatureCentiF(uint8_t deviceIndex)
+{
+	if (this->indexExist(deviceIndex))
+		return rawToCentiFahrenheit(this->_temperatures[deviceIndex]);
+	else
+		return (int32_t)(DEVICE_DISCONNECTED_F * 100);
+}
+
+/**
+ * @brief Get Temperature from sensor index in °C with 8 fractional bits (1/256 °C)
+ *
+ * @return int32_t temperature IF index exist
+ * @return DEVICE_DISCONNECTED_C * 256 if index not exist
+ */
+int32_t NonBlockingDallasBase::getTemperatureQ8C(uint8_t deviceIndex)
+{
+	if (this->indexExist(deviceIndex))
+		return rawToCelsiusQ8(this->_temperatures[deviceIndex]);
+	else
+		return DEVICE_DISCONNECTED_C * 256;
+}
+
+/**
+ * @brief Get Temperature from sensor index in °F with 8 fractional bits (1/256 °F)
+ *
+ * @return int32_t temperature IF index exist
+ * @return DEVICE_DISCONNECTED_F * 256 if index not exist
+ */
+int32_t NonBlockingDallasBase::getTemperatureQ8F(uint8_t deviceIndex)
+{
+	if (this->indexExist(deviceIndex))
+		return rawToFahrenheitQ8(this->_temperatures[deviceIndex]);
+	else
+		return (int32_t)(DEVICE_DISCONNECTED_F * 256);
+}
+
+/**
+ * @brief Convert the temperatures of all the sensors in one pass
+ *
+ * @param buffer receives the temperature of sensor i at position i
+ * @param size number of elements of buffer
+ * @return number of temperatures written
+ */
+uint8_t NonBlockingDallasBase::getTemperatures(int32_t *buffer, uint8_t size, integerUnit unit)
+{
+	uint8_t count = this->_sensorsCount < size ? this->_sensorsCount : size;
+	convertRAW(this->_temperatures, buffer, count, unit);
+	return count;
+}
+
+/**
+ * @brief Temperatures of the sensors of a query in one pass
+ *
+ * @param buffer receives the temperature of the address i of the query at position i,
+ * DEVICE_DISCONNECTED_RAW for an address not on the bus
+ * @return number of addresses found on the bus
+ */
+uint8_t NonBlockingDallasBase::getTemperaturesRAW(NonBlockingDallasQuery &query, int32_t *buffer)
+{
+	resolveQuery(query);
+	for (uint8_t i = 0; i < query._count; i++)
+	{
+		int8_t deviceIndex = query._indexes[i];
+		buffer[i] = deviceIndex >= 0 ? this->_temperatures[deviceIndex] : DEVICE_DISCONNECTED_RAW;
+	}
+	return query._found;
+}
+
+/**
+ * @brief Temperatures of the sensors of a query converted in one pass, see getTemperaturesRAW()
+ */
+uint8_t NonBlockingDallasBase::getTemperatures(NonBlockingDallasQuery &query, int32_t *buffer, integerUnit unit)
+{
+	uint8_t found = getTemperaturesRAW(query, buffer);
+	convertRAW(buffer, buffer, query._count, unit);
+	return found;
+}
+
+/**
+ * @brief Generation of the address table, changed each time a sensor is added or the table is rebuilt
+ */
+uint16_t NonBlockingDallasBase::getTableGeneration()
+{
+	return _tableGeneration;
+}
+
 /**
  * Functions below get by DeviceAddress
  */
@@ -315,13 +2408,19 @@ float NonBlockingDallas::getTemperatureF(uint8_t deviceIndex)
  * @return -1 address not found
  * @return -2 bus have no sensor
  */
-int8_t NonBlockingDallas::getIndex(DeviceAddress deviceAddress)
+int8_t NonBlockingDallasBase::getIndex(const DeviceAddress deviceAddress)
 {
 	if (this->_sensorsCount > 0)
 	{
-		for (size_t i = 0; i < this->_sensorsCount; i++)
+		// Only the sensors sharing the hash slot are compared
+		uint8_t slot = this->addressLookupSlot(deviceAddress);
+		while (this->_addressLookup[slot] != 0)
+		{
+			uint8_t i = this->_addressLookup[slot] - 1;
 			if (this->compareTowDeviceAddresses(this->_sensorAddresses[i], deviceAddress))
 				return i;
+			slot = (slot + 1) & this->_lookupMask;
+		}
 		return -1;
 	}
 	else
@@ -336,9 +2435,9 @@ int8_t NonBlockingDallas::getIndex(DeviceAddress deviceAddress)
  * @return int32_t temperature IF DeviceAddress exist
  * @return DEVICE_DISCONNECTED_RAW if DeviceAddress not exist
  */
-int32_t NonBlockingDallas::getTemperatureRAW(DeviceAddress deviceAddress)
+int32_t NonBlockingDallasBase::getTemperatureRAW(const DeviceAddress deviceAddress)
 {
-	uint8_t tempIndex = this->getIndex(deviceAddress);
+	int8_t tempIndex = this->getIndex(deviceAddress);
 	if (tempIndex >= 0)
 		return this->_temperatures[tempIndex];
 	else
@@ -351,9 +2450,9 @@ int32_t NonBlockingDallas::getTemperatureRAW(DeviceAddress deviceAddress)
  * @return float temperature IF DeviceAddress exist
  * @return DEVICE_DISCONNECTED_C if DeviceAddress not exist
  */
-float NonBlockingDallas::getTemperatureC(DeviceAddress deviceAddress)
+float NonBlockingDallasBase::getTemperatureC(const DeviceAddress deviceAddress)
 {
-	uint8_t tempIndex = this->getIndex(deviceAddress);
+	int8_t tempIndex = this->getIndex(deviceAddress);
 	if (tempIndex >= 0)
 		return this->rawToCelsius(this->_temperatures[tempIndex]);
 	else
@@ -366,42 +2465,43 @@ float NonBlockingDallas::getTemperatureC(DeviceAddress deviceAddress)
  * @return float temperature IF DeviceAddress exist
  * @return DEVICE_DISCONNECTED_F if DeviceAddress not exist
  */
-float NonBlockingDallas::getTemperatureF(DeviceAddress deviceAddress)
+float NonBlockingDallasBase::getTemperatureF(const DeviceAddress deviceAddress)
 {
-	uint8_t tempIndex = this->getIndex(deviceAddress);
+	int8_t tempIndex = this->getIndex(deviceAddress);
 	if (tempIndex >= 0)
-		return this->rawToCelsius(this->_temperatures[tempIndex]);
+		return this->rawToFahrenheit(this->_temperatures[tempIndex]);
 	else
 		return DEVICE_DISCONNECTED_F;
 }
 
 /**
- * Functions below get by String address representation
+ * Functions below get by address string representation
  */
 
 /**
- * @brief Get device index from address String representation
+ * @brief Get device index from address string representation
  *
  * @return  x position index : 0 <= x < _sensorsCount
- * @return -1 address not found
+ * @return -1 address not found or not valid
  * @return -2 bus have no sensor
  */
-int8_t NonBlockingDallas::getIndex(String addressString)
+int8_t NonBlockingDallasBase::getIndex(const char *addressString)
 {
 	DeviceAddress tmpAddress;
-	this->convertDeviceAddressStringToDeviceAddress(addressString, tmpAddress);
+	if (!parseAddress(addressString, tmpAddress))
+		return this->_sensorsCount > 0 ? -1 : -2;
 	return this->getIndex(tmpAddress);
 }
 
 /**
- * @brief Get RAW Temperature from sensor address String representation
+ * @brief Get RAW Temperature from sensor address string representation
  *
- * @return int32_t temperature IF address String representation exist
- * @return DEVICE_DISCONNECTED_RAW if address String representation not exist
+ * @return int32_t temperature IF address string representation exist
+ * @return DEVICE_DISCONNECTED_RAW if address string representation not exist
  */
-int32_t NonBlockingDallas::getTemperatureRAW(String addressString)
+int32_t NonBlockingDallasBase::getTemperatureRAW(const char *addressString)
 {
-	uint8_t tempIndex = this->getIndex(addressString);
+	int8_t tempIndex = this->getIndex(addressString);
 	if (tempIndex >= 0)
 		return this->_temperatures[tempIndex];
 	else
@@ -409,14 +2509,14 @@ int32_t NonBlockingDallas::getTemperatureRAW(String addressString)
 }
 
 /**
- * @brief Get Temperature from sensor address String representation
+ * @brief Get Temperature from sensor address string representation
  *
- * @return float temperature IF address String representation exist
- * @return DEVICE_DISCONNECTED_C if address String representation not exist
+ * @return float temperature IF address string representation exist
+ * @return DEVICE_DISCONNECTED_C if address string representation not exist
  */
-float NonBlockingDallas::getTemperatureC(String addressString)
+float NonBlockingDallasBase::getTemperatureC(const char *addressString)
 {
-	uint8_t tempIndex = this->getIndex(addressString);
+	int8_t tempIndex = this->getIndex(addressString);
 	if (tempIndex >= 0)
 		return this->rawToCelsius(this->_temperatures[tempIndex]);
 	else
@@ -424,20 +2524,40 @@ float NonBlockingDallas::getTemperatureC(String addressString)
 }
 
 /**
- * @brief Get Temperature from sensor address String representation
+ * @brief Get Temperature from sensor address string representation
  *
- * @return float temperature IF address String representation exist
- * @return DEVICE_DISCONNECTED_F if address String representation not exist
+ * @return float temperature IF address string representation exist
+ * @return DEVICE_DISCONNECTED_F if address string representation not exist
  */
-float NonBlockingDallas::getTemperatureF(String addressString)
+float NonBlockingDallasBase::getTemperatureF(const char *addressString)
 {
-	uint8_t tempIndex = this->getIndex(addressString);
+	int8_t tempIndex = this->getIndex(addressString);
 	if (tempIndex >= 0)
-		return this->rawToCelsius(this->_temperatures[tempIndex]);
+		return this->rawToFahrenheit(this->_temperatures[tempIndex]);
 	else
 		return DEVICE_DISCONNECTED_F;
 }
 
+int8_t NonBlockingDallasBase::getIndex(const String &addressString)
+{
+	return this->getIndex(addressString.c_str());
+}
+
+int32_t NonBlockingDallasBase::getTemperatureRAW(const String &addressString)
+{
+	return this->getTemperatureRAW(addressString.c_str());
+}
+
+float NonBlockingDallasBase::getTemperatureC(const String &addressString)
+{
+	return this->getTemperatureC(addressString.c_str());
+}
+
+float NonBlockingDallasBase::getTemperatureF(const String &addressString)
+{
+	return this->getTemperatureF(addressString.c_str());
+}
+
 /**
  * Functions below are helpers
  */
@@ -448,7 +2568,7 @@ float NonBlockingDallas::getTemperatureF(String addressString)
  * @return true if addresses are the same
  * @return false if not the same
  */
-bool NonBlockingDallas::compareTowDeviceAddresses(DeviceAddress deviceAddress1, DeviceAddress deviceAddress2)
+bool NonBlockingDallasBase::compareTowDeviceAddresses(const DeviceAddress deviceAddress1, const DeviceAddress deviceAddress2)
 {
 	for (size_t i = 0; i < 8; i++)
 		if (deviceAddress1[i] != deviceAddress2[i])
@@ -457,20 +2577,56 @@ bool NonBlockingDallas::compareTowDeviceAddresses(DeviceAddress deviceAddress1,
 }
 
 /**
- * @brief Convert a DeviceAddress to address String representation
+ * @brief Write the address string representation of a DeviceAddress into a caller buffer
  *
- * @return String representation of the address
+ * 16 lowercase hex digits followed by the terminator, no heap allocation
  */
-String NonBlockingDallas::convertDeviceAddressToString(DeviceAddress deviceAddress)
+void NonBlockingDallasBase::formatAddress(const DeviceAddress deviceAddress, char addressString[17])
 {
-	String addressString = "";
+	static const char hexDigits[] = "0123456789abcdef";
 	for (size_t i = 0; i < 8; i++)
 	{
-		if (deviceAddress[i] < 16)
-			addressString += "0";
-		addressString += String(deviceAddress[i], HEX);
+		addressString[2 * i] = hexDigits[deviceAddress[i] >> 4];
+		addressString[2 * i + 1] = hexDigits[deviceAddress[i] & 0x0F];
+	}
+	addressString[16] = '\0';
+}
+
+/**
+ * @brief Convert an address string representation to a DeviceAddress, no heap allocation
+ *
+ * @return true if the string is made of 16 hex digits, deviceAddress is left untouched otherwise
+ * @return false if length or digits are wrong
+ */
+bool NonBlockingDallasBase::parseAddress(const char *addressString, DeviceAddress deviceAddress)
+{
+	if (addressString == NULL)
+		return false;
+
+	// A shorter string stops on its terminator, which is not a hex digit
+	for (size_t i = 0; i < 16; i++)
+	{
+		if (charToHex(addressString[i]) == 255)
+			return false;
 	}
-	return addressString;
+	if (addressString[16] != '\0')
+		return false;
+
+	for (size_t i = 0; i < 8; i++)
+		deviceAddress[i] = (charToHex(addressString[2 * i]) << 4) | charToHex(addressString[2 * i + 1]);
+	return true;
+}
+
+/**
+ * @brief Convert a DeviceAddress to address String representation
+ *
+ * @return String representation of the address
+ */
+String NonBlockingDallasBase::convertDeviceAddressToString(const DeviceAddress deviceAddress)
+{
+	char addressString[17];
+	formatAddress(deviceAddress, addressString);
+	return String(addressString);
 }
 
 /**
@@ -479,23 +2635,9 @@ String NonBlockingDallas::convertDeviceAddressToString(DeviceAddress deviceAddre
  * @return true if string lenght is good
  * @return false if string lenght is wrong
  */
-bool NonBlockingDallas::convertDeviceAddressStringToDeviceAddress(String addressString, DeviceAddress deviceAddress)
+bool NonBlockingDallasBase::convertDeviceAddressStringToDeviceAddress(const String &addressString, DeviceAddress deviceAddress)
 {
-	if (addressString.length() == 16)
-	{
-		for (size_t i = 0; i < 8; i++)
-		{
-			char cMSB = addressString[2 * i];
-			char cLSB = addressString[2 * i + 1];
-			uint8_t tmpValue = 0;
-			if (towCharToHex(cMSB, cLSB, &tmpValue))
-				deviceAddress[i] = tmpValue;
-			else
-				return false;
-		}
-		return true;
-	}
-	return false;
+	return parseAddress(addressString.c_str(), deviceAddress);
 }
 
 /**
@@ -503,7 +2645,7 @@ bool NonBlockingDallas::convertDeviceAddressStringToDeviceAddress(String address
  *
  * @return float temperature in °C
  */
-float NonBlockingDallas::rawToCelsius(int32_t rawTemperature)
+float NonBlockingDallasBase::rawToCelsius(int32_t rawTemperature)
 {
 	return (float)rawTemperature * 0.0078125f;
 }
@@ -513,11 +2655,73 @@ float NonBlockingDallas::rawToCelsius(int32_t rawTemperature)
  *
  * @return float temperature in °F
  */
-float NonBlockingDallas::rawToFahrenheit(int32_t rawTemperature)
+float NonBlockingDallasBase::rawToFahrenheit(int32_t rawTemperature)
 {
 	return ((float)rawTemperature * 0.0140625f) + 32.0f;
 }
 
+/**
+ * @brief Convert a RAW Temperature to hundredths of °C, rounded, without floating point
+ */
+int32_t NonBlockingDallasBase::rawToCentiCelsius(int32_t rawTemperature)
+{
+	return (rawTemperature * 25 + 16) >> 5; // 100 / 128
+}
+
+/**
+ * @brief Convert a RAW Temperature to hundredths of °F, rounded, without floating point
+ */
+int32_t NonBlockingDallasBase::rawToCentiFahrenheit(int32_t rawTemperature)
+{
+	return ((rawTemperature * 45 + 16) >> 5) + 3200; // 100 * 9 / 5 / 128
+}
+
+/**
+ * @brief Convert a RAW Temperature to °C with 8 fractional bits, exact
+ */
+int32_t NonBlockingDallasBase::rawToCelsiusQ8(int32_t rawTemperature)
+{
+	return rawTemperature * 2;
+}
+
+/**
+ * @brief Convert a RAW Temperature to °F with 8 fractional bits, rounded
+ */
+int32_t NonBlockingDallasBase::rawToFahrenheitQ8(int32_t rawTemperature)
+{
+	int32_t scaled = rawTemperature * 18; // 256 * 9 / 128, to be divided by 5
+	return (scaled + (scaled >= 0 ? 2 : -2)) / 5 + 32 * 256;
+}
+
+/**
+ * @brief Convert an array of RAW Temperatures, raw and converted may be the same array
+ *
+ * Each unit has its own loop without calls nor branches on the data, so that the compiler
+ * can vectorize it on targets with SIMD instructions.
+ */
+void NonBlockingDallasBase::convertRAW(const int32_t *raw, int32_t *converted, uint8_t count, integerUnit unit)
+{
+	switch (unit)
+	{
+	case centiCelsius:
+		for (uint8_t i = 0; i < count; i++)
+			converted[i] = rawToCentiCelsius(raw[i]);
+		break;
+	case centiFahrenheit:
+		for (uint8_t i = 0; i < count; i++)
+			converted[i] = rawToCentiFahrenheit(raw[i]);
+		break;
+	case celsiusQ8:
+		for (uint8_t i = 0; i < count; i++)
+			converted[i] = rawToCelsiusQ8(raw[i]);
+		break;
+	case fahrenheitQ8:
+		for (uint8_t i = 0; i < count; i++)
+			converted[i] = rawToFahrenheitQ8(raw[i]);
+		break;
+	}
+}
+
 /**
  * @brief Validate a DeviceAdress[] range
  *
@@ -526,7 +2730,7 @@ float NonBlockingDallas::rawToFahrenheit(int32_t rawTemperature)
  * @return true if all devices are finds in the bus
  * @return false if not all devices are finds in the bus
  */
-bool NonBlockingDallas::validateAddressesRange(DeviceAddress addressesRangeToValidate[], uint8_t numberOfAddresses, bool exclusiveListSet)
+bool NonBlockingDallasBase::validateAddressesRange(DeviceAddress addressesRangeToValidate[], uint8_t numberOfAddresses, bool exclusiveListSet)
 {
 	// Exclusif mode, number of device must be equal
 	if (exclusiveListSet && (numberOfAddresses != this->_sensorsCount))
@@ -541,6 +2745,29 @@ bool NonBlockingDallas::validateAddressesRange(DeviceAddress addressesRangeToVal
 	return true;
 }
 
+/**
+ * @brief Validate an addresses string representation [] range
+ *
+ * @param exclusiveListSet IF set to true, bus can't not have others devices than there listed
+ *
+ * @return true if all devices are finds in the bus
+ * @return false if not all devices are finds in the bus
+ */
+bool NonBlockingDallasBase::validateAddressesRange(const char *const addressesStrings[], uint8_t numberOfAddresses, bool exclusiveListSet)
+{
+	// Exclusif mode, number of device must be equal
+	if (exclusiveListSet && (numberOfAddresses != this->_sensorsCount))
+		return false;
+
+	// check if we find all the devices expected
+	for (size_t i = 0; i < numberOfAddresses; i++)
+	{
+		if (this->getIndex(addressesStrings[i]) < 0)
+			return false;
+	}
+	return true;
+}
+
 /**
  * @brief Validate a String addresses [] range
  *
@@ -549,13 +2776,31 @@ bool NonBlockingDallas::validateAddressesRange(DeviceAddress addressesRangeToVal
  * @return true if all devices are finds in the bus
  * @return false if not all devices are finds in the bus
  */
-bool NonBlockingDallas::validateAddressesRange(String addressesStrings[], uint8_t numberOfAddresses, bool exclusiveListSet)
+bool NonBlockingDallasBase::validateAddressesRange(const String addressesStrings[], uint8_t numberOfAddresses, bool exclusiveListSet)
 {
-	DeviceAddress tmpAddresses[numberOfAddresses];
+	if (exclusiveListSet && (numberOfAddresses != this->_sensorsCount))
+		return false;
+
 	for (size_t i = 0; i < numberOfAddresses; i++)
-		this->convertDeviceAddressStringToDeviceAddress(addressesStrings[i], tmpAddresses[i]);
+	{
+		if (this->getIndex(addressesStrings[i].c_str()) < 0)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Validate the addresses of a query, resolved only when the table changed
+ *
+ * @param exclusiveListSet IF set to true, bus can't not have others devices than there listed
+ */
+bool NonBlockingDallasBase::validateAddressesRange(NonBlockingDallasQuery &query, bool exclusiveListSet)
+{
+	if (exclusiveListSet && (query._count != this->_sensorsCount))
+		return false;
 
-	return this->validateAddressesRange(tmpAddresses, numberOfAddresses, exclusiveListSet);
+	resolveQuery(query);
+	return query._found == query._count;
 }
 
 /**
@@ -564,7 +2809,7 @@ bool NonBlockingDallas::validateAddressesRange(String addressesStrings[], uint8_
  * @return uint8_t HEX Numbrer
  * @return 255 if char is not valide
  */
-uint8_t NonBlockingDallas::charToHex(char c)
+uint8_t NonBlockingDallasBase::charToHex(char c)
 {
 	if ((c >= '0') && (c <= '9'))
 		return c - '0';
@@ -581,7 +2826,7 @@ uint8_t NonBlockingDallas::charToHex(char c)
  * @return true if conversion work
  * @return false if conversion fail
  */
-bool NonBlockingDallas::towCharToHex(char MSB, char LSB, uint8_t *ptrValue)
+bool NonBlockingDallasBase::towCharToHex(char MSB, char LSB, uint8_t *ptrValue)
 {
 	uint8_t uMSB = charToHex(MSB);
 	uint8_t uLSB = charToHex(LSB);
@@ -604,8 +2849,79 @@ bool NonBlockingDallas::towCharToHex(char MSB, char LSB, uint8_t *ptrValue)
  * x = -1 if not found
  * x = -2 if no sensor at all is detected
  */
-void NonBlockingDallas::mapIndexPositionOfDeviceAddressRange(DeviceAddress addressesRangeToValidate[], uint8_t numberOfAddresses, int8_t mapedPositions[])
+void NonBlockingDallasBase::mapIndexPositionOfDeviceAddressRange(DeviceAddress addressesRangeToValidate[], uint8_t numberOfAddresses, int8_t mapedPositions[])
 {
 	for (size_t i = 0; i < numberOfAddresses; i++)
 		mapedPositions[i] = this->getIndex(addressesRangeToValidate[i]);
 }
+
+/**
+ * @brief Map index positions of the addresses of a query, resolved only when the table changed
+ */
+void NonBlockingDallasBase::mapIndexPositionOfDeviceAddressRange(NonBlockingDallasQuery &query, int8_t mapedPositions[])
+{
+	resolveQuery(query);
+	for (uint8_t i = 0; i < query._count; i++)
+		mapedPositions[i] = query._indexes[i];
+}
+
+NonBlockingDallasQuery::NonBlockingDallasQuery(DeviceAddress *addresses, int8_t *indexes, uint8_t capacity)
+{
+	_addresses = addresses;
+	_indexes = indexes;
+	_capacity = capacity;
+	_count = 0;
+	_found = 0;
+	_resolvedBy = NULL;
+	_resolvedGeneration = 0;
+}
+
+/**
+ * @brief Set the addresses of the query, resolved by the next call using it
+ *
+ * @return false if there are more addresses than the query holds, the query is then left unchanged
+ */
+bool NonBlockingDallasQuery::setAddresses(const DeviceAddress addresses[], uint8_t count)
+{
+	if (count > _capacity)
+		return false;
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		for (uint8_t b = 0; b < 8; b++)
+			_addresses[i][b] = addresses[i][b];
+	}
+	_count = count;
+	_resolvedBy = NULL;
+	return true;
+}
+
+/**
+ * @brief Set the addresses of the query from their string representation, parsed once
+ *
+ * @return false if there are more addresses than the query holds or an address is not valid,
+ * the query is then left unchanged
+ */
+bool NonBlockingDallasQuery::setAddresses(const char *const addressesStrings[], uint8_t count)
+{
+	if (count > _capacity)
+		return false;
+
+	// All the strings are checked before the first address is overwritten
+	DeviceAddress address;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (!NonBlockingDallasBase::parseAddress(addressesStrings[i], address))
+			return false;
+	}
+	for (uint8_t i = 0; i < count; i++)
+		NonBlockingDallasBase::parseAddress(addressesStrings[i], _addresses[i]);
+	_count = count;
+	_resolvedBy = NULL;
+	return true;
+}
+
+uint8_t NonBlockingDallasQuery::getCount()
+{
+	return _count;
+}
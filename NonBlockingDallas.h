@@ -26,10 +26,144 @@
 #include <Arduino.h>
 #include <DallasTemperature.h>
 #define DEFAULT_INTERVAL 30000
-#define ONE_WIRE_MAX_DEV 15 // Maximum number of devices on the One wire bus
+#define DEFAULT_DISCOVERY_BITS 8 // ROM bits searched by each update() call while looking for new devices
+#define ONE_WIRE_MAX_DEV 15 // Maximum number of devices on the One wire bus of NonBlockingDallas, see NonBlockingDallasN for other capacities
 // #define DEBUG_DS18B20
 
-class NonBlockingDallas
+// Time source of the state machine. The .cpp files of the library are compiled on their own, so another
+// clock is chosen with a build flag naming a function, -DNBD_MILLIS=simulatedMillis, defined by the sketch
+#ifdef NBD_MILLIS
+unsigned long NBD_MILLIS();
+#else
+#define NBD_MILLIS millis
+#endif
+#ifdef NBD_MICROS
+unsigned long NBD_MICROS();
+#else
+#define NBD_MICROS micros
+#endif
+
+// Orders the memory accesses of the snapshot and of the event queue shared with another core or task
+#ifndef NBD_MEMORY_BARRIER
+#if defined(__AVR__)
+#define NBD_MEMORY_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define NBD_MEMORY_BARRIER() __sync_synchronize()
+#endif
+#endif
+
+// Readings a sensor keeps the near resolution of the adaptive mode before going back to the far one
+#ifndef ADAPTIVE_RESOLUTION_HOLD
+#define ADAPTIVE_RESOLUTION_HOLD 4
+#endif
+
+class NonBlockingDallasHistory;
+class NonBlockingDallasEventQueue;
+class NonBlockingDallasTrace;
+class NonBlockingDallasStats;
+class NonBlockingDallasSnapshot;
+class NonBlockingDallasTimings;
+class NonBlockingDallasChangeFilter;
+class NonBlockingDallasThresholds;
+class NonBlockingDallasAdaptive;
+class NonBlockingDallasConversionTimes;
+
+// Smallest power of two holding twice the capacity, keeps the address lookup at most half full
+constexpr uint16_t nbdLookupSize(uint16_t capacity, uint16_t size = 1)
+{
+	return size >= 2 * capacity ? size : nbdLookupSize(capacity, size * 2);
+}
+
+uint8_t nbdInvalidAddressCharacter(); // Not constexpr: reports a bad NonBlockingDallasAddress literal at compile time
+
+constexpr uint8_t nbdHexDigit(char c)
+{
+	return (c >= '0' && c <= '9')	? c - '0'
+		   : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+		   : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+									: nbdInvalidAddressCharacter();
+}
+
+/**
+ * Address literal resolved at compile time, usable wherever a DeviceAddress is read:
+ *
+ * constexpr NonBlockingDallasAddress freezer("28ff641e0f1b2c3d");
+ * temperatureSensors.getTemperatureC(freezer);
+ */
+struct NonBlockingDallasAddress
+{
+	uint8_t bytes[8];
+
+	constexpr NonBlockingDallasAddress(const char (&addressString)[17])
+		: bytes{byteAt(addressString, 0), byteAt(addressString, 1), byteAt(addressString, 2), byteAt(addressString, 3),
+				byteAt(addressString, 4), byteAt(addressString, 5), byteAt(addressString, 6), byteAt(addressString, 7)}
+	{
+	}
+
+	operator const uint8_t *() const
+	{
+		return bytes;
+	}
+
+private:
+	static constexpr uint8_t byteAt(const char (&addressString)[17], uint8_t i)
+	{
+		return (nbdHexDigit(addressString[2 * i]) << 4) | nbdHexDigit(addressString[2 * i + 1]);
+	}
+};
+
+class NonBlockingDallasBase;
+
+/**
+ * List of sensor addresses resolved to indexes once, and again only when the table of the bus
+ * changes, so that repeated lookups compare no address. The storage is provided by NonBlockingDallasQueryN
+ */
+class NonBlockingDallasQuery
+{
+	friend class NonBlockingDallasBase;
+
+public:
+	bool setAddresses(const DeviceAddress addresses[], uint8_t count);
+	bool setAddresses(const char *const addressesStrings[], uint8_t count);
+	uint8_t getCount();
+
+protected:
+	NonBlockingDallasQuery(DeviceAddress *addresses, int8_t *indexes, uint8_t capacity);
+
+private:
+	DeviceAddress *_addresses;
+	int8_t *_indexes;						 // getIndex() of each address
+	uint8_t _capacity;
+	uint8_t _count;
+	uint8_t _found;							 // Addresses found on the bus
+	const NonBlockingDallasBase *_resolvedBy; // Bus of the indexes, NULL if not resolved
+	uint16_t _resolvedGeneration;			 // Table generation of the bus when resolved
+};
+
+/**
+ * Query of up to COUNT addresses
+ */
+template <uint8_t COUNT>
+class NonBlockingDallasQueryN : public NonBlockingDallasQuery
+{
+	static_assert(COUNT > 0, "NonBlockingDallasQueryN needs at least one address");
+
+public:
+	NonBlockingDallasQueryN()
+		: NonBlockingDallasQuery(_addressSlots, _indexSlots, COUNT)
+	{
+	}
+
+private:
+	DeviceAddress _addressSlots[COUNT];
+	int8_t _indexSlots[COUNT];
+};
+
+/**
+ * State machine shared by NonBlockingDallas and NonBlockingDallasN, the per-sensor
+ * arrays are provided by the derived class so that their size is chosen at compile time
+ */
+class NonBlockingDallasBase
 {
 
 public:
@@ -41,10 +175,62 @@ public:
 		resolution_12 = 12
 	};
 
-	NonBlockingDallas(DallasTemperature *dallasTemp);
+	enum integerUnit
+	{
+		centiCelsius,	 // Hundredths of °C
+		centiFahrenheit, // Hundredths of °F
+		celsiusQ8,		 // 1/256 °C
+		fahrenheitQ8	 // 1/256 °F
+	};
+
 	void begin(resolution res, unsigned long tempInterval);
+	bool beginFromCache(const uint8_t *cache, size_t cacheSize, resolution res, unsigned long tempInterval);
+	size_t exportCache(uint8_t *cache, size_t cacheSize);
+	static constexpr size_t getCacheSize(uint8_t sensorsCount) // Bytes needed by exportCache()
+	{
+		return 4 + 9 * (size_t)sensorsCount + 2;
+	}
+	size_t exportCycle(uint8_t *buffer, size_t bufferSize);
+	static constexpr size_t getCycleRecordSize(uint8_t samplesCount) // Largest record written by exportCycle()
+	{
+		return 12 + 7 * (size_t)samplesCount;
+	}
+	bool getSampleTimes(uint8_t deviceIndex, unsigned long &conversionMillis, unsigned long &readMillis);
 	void update();
 	void requestTemperature();
+	void setReadoutSlice(uint8_t sensorsPerUpdate, unsigned long budgetMicros = 0);
+	bool setSensorInterval(uint8_t deviceIndex, unsigned long interval);
+	unsigned long getSensorInterval(uint8_t deviceIndex);
+	void setMergeWindow(unsigned long mergeWindow);
+	bool setThresholds(uint8_t deviceIndex, int32_t lowRAW, int32_t highRAW);
+	void setAdaptiveInterval(unsigned long minInterval, unsigned long maxInterval, uint16_t stableRAW, uint16_t marginRAW);
+	void setAdaptiveResolution(resolution farRes, resolution nearRes, uint16_t nearRAW);
+	void setAlarmMode(uint8_t fullSweepCycles);
+	void setTimedWait(bool timedWait);
+	bool setFastRead(uint8_t fullReadCycles, uint16_t maxJumpRAW = 0);
+	void setSkipRom(bool skipRom);
+	bool isSkipRomActive();
+	uint8_t getSensorResolution(uint8_t deviceIndex);
+	unsigned long getConversionMillis(uint8_t deviceIndex);
+	void setDiscovery(uint8_t bitsPerUpdate, unsigned long interval);
+	void setIndexOffset(uint8_t indexOffset);
+	void attachHistory(NonBlockingDallasHistory *history);
+	void attachEventQueue(NonBlockingDallasEventQueue *eventQueue);
+	void attachTrace(NonBlockingDallasTrace *trace);
+	void attachStats(NonBlockingDallasStats *stats);
+	void attachSnapshot(NonBlockingDallasSnapshot *snapshot);
+	void attachTimings(NonBlockingDallasTimings *timings);
+	void attachChangeFilter(NonBlockingDallasChangeFilter *changeFilter);
+	void attachThresholds(NonBlockingDallasThresholds *thresholds);
+	void attachAdaptive(NonBlockingDallasAdaptive *adaptive);
+	void attachConversionTimes(NonBlockingDallasConversionTimes *conversionTimes);
+	uint32_t getCycleCount();
+	uint8_t dispatch(uint8_t maxEvents = 0, unsigned long budgetMicros = 0);
+	bool setChangeFilter(uint8_t deviceIndex, uint16_t deadbandRAW, uint16_t hysteresisRAW = 0);
+	void setChangeFilterAll(uint16_t deadbandRAW, uint16_t hysteresisRAW = 0);
+	void setMinChangeInterval(unsigned long minChangeInterval);
+	bool isReadoutPending();
+	unsigned long millisToNextUpdate();
 	void onIntervalElapsed(void (*callback)(int deviceIndex, int32_t temperatureRAW))
 	{
 		cb_onIntervalElapsed = callback;
@@ -57,80 +243,314 @@ public:
 	{
 		cb_onDeviceDisconnected = callback;
 	}
+	void onCycleComplete(void (*callback)(const int32_t *temperaturesRAW, uint8_t sensorsCount, const uint8_t *validMask, const uint8_t *changedMask))
+	{
+		cb_onCycleComplete = callback;
+	}
+	void onScheduleChange(void (*callback)(unsigned long millisToNextUpdate))
+	{
+		cb_onScheduleChange = callback;
+	}
+	static bool isMaskSet(const uint8_t *mask, uint8_t deviceIndex)
+	{
+		return (mask[deviceIndex >> 3] >> (deviceIndex & 7)) & 1;
+	}
 
 	uint8_t getSensorsCount();
+	uint8_t getCapacity();
 
 	/**
 	 * Functions below get by deviceIndex
 	 */
 
 	bool indexExist(uint8_t deviceIndex);
+	bool isSensorPresent(uint8_t deviceIndex);
 	bool getDeviceAddress(uint8_t deviceIndex, DeviceAddress deviceAddress);
 	String getAddressString(uint8_t deviceIndex);
+	bool getAddressString(uint8_t deviceIndex, char addressString[17]);
 	int32_t getTemperatureRAW(uint8_t deviceIndex);
 	float getTemperatureC(uint8_t deviceIndex);
 	float getTemperatureF(uint8_t deviceIndex);
+	int32_t getTemperatureCentiC(uint8_t deviceIndex);
+	int32_t getTemperatureCentiF(uint8_t deviceIndex);
+	int32_t getTemperatureQ8C(uint8_t deviceIndex);
+	int32_t getTemperatureQ8F(uint8_t deviceIndex);
+	uint8_t getTemperatures(int32_t *buffer, uint8_t size, integerUnit unit);
+	uint8_t getTemperaturesRAW(NonBlockingDallasQuery &query, int32_t *buffer);
+	uint8_t getTemperatures(NonBlockingDallasQuery &query, int32_t *buffer, integerUnit unit);
+	uint16_t getTableGeneration();
 
 	/**
 	 * Functions below get by DeviceAddress
 	 */
 
-	int8_t getIndex(DeviceAddress deviceAddress); // can be sused to test if address exist
-	int32_t getTemperatureRAW(DeviceAddress deviceAddress);
-	float getTemperatureC(DeviceAddress deviceAddress);
-	float getTemperatureF(DeviceAddress deviceAddress);
+	int8_t getIndex(const DeviceAddress deviceAddress); // can be sused to test if address exist
+	int32_t getTemperatureRAW(const DeviceAddress deviceAddress);
+	float getTemperatureC(const DeviceAddress deviceAddress);
+	float getTemperatureF(const DeviceAddress deviceAddress);
 
 	/**
-	 * Functions below get by String address representation
+	 * Functions below get by address string representation, String versions wrap the char versions
 	 */
 
-	int8_t getIndex(String addressString); // can be sused to test if address exist
-	int32_t getTemperatureRAW(String addressString);
-	float getTemperatureC(String addressString);
-	float getTemperatureF(String addressString);
+	int8_t getIndex(const char *addressString); // can be sused to test if address exist
+	int32_t getTemperatureRAW(const char *addressString);
+	float getTemperatureC(const char *addressString);
+	float getTemperatureF(const char *addressString);
+	int8_t getIndex(const String &addressString);
+	int32_t getTemperatureRAW(const String &addressString);
+	float getTemperatureC(const String &addressString);
+	float getTemperatureF(const String &addressString);
 
 	/**
 	 * Functions below are helpers
 	 */
 
-	bool compareTowDeviceAddresses(DeviceAddress deviceAddress1, DeviceAddress deviceAddress2);
-	String convertDeviceAddressToString(DeviceAddress deviceAddress);
-	bool convertDeviceAddressStringToDeviceAddress(String addressString, DeviceAddress deviceAddress);
+	bool compareTowDeviceAddresses(const DeviceAddress deviceAddress1, const DeviceAddress deviceAddress2);
+	static void formatAddress(const DeviceAddress deviceAddress, char addressString[17]);
+	static bool parseAddress(const char *addressString, DeviceAddress deviceAddress);
+	String convertDeviceAddressToString(const DeviceAddress deviceAddress);
+	bool convertDeviceAddressStringToDeviceAddress(const String &addressString, DeviceAddress deviceAddress);
 	float rawToCelsius(int32_t rawTemperature);
 	float rawToFahrenheit(int32_t rawTemperature);
+	static int32_t rawToCentiCelsius(int32_t rawTemperature);
+	static int32_t rawToCentiFahrenheit(int32_t rawTemperature);
+	static int32_t rawToCelsiusQ8(int32_t rawTemperature);
+	static int32_t rawToFahrenheitQ8(int32_t rawTemperature);
+	static void convertRAW(const int32_t *raw, int32_t *converted, uint8_t count, integerUnit unit);
 	bool validateAddressesRange(DeviceAddress addressesRangeToValidate[], uint8_t numberOfAddresses, bool exclusiveListSet = true);
-	bool validateAddressesRange(String addressesStrings[], uint8_t numberOfAddresses, bool exclusiveListSet = true);
-	uint8_t charToHex(char c);
-	bool towCharToHex(char MSB, char LSB, uint8_t *ptrValue);
+	bool validateAddressesRange(const char *const addressesStrings[], uint8_t numberOfAddresses, bool exclusiveListSet = true);
+	bool validateAddressesRange(const String addressesStrings[], uint8_t numberOfAddresses, bool exclusiveListSet = true);
+	bool validateAddressesRange(NonBlockingDallasQuery &query, bool exclusiveListSet = true);
+	static uint8_t charToHex(char c);
+	static bool towCharToHex(char MSB, char LSB, uint8_t *ptrValue);
 	void mapIndexPositionOfDeviceAddressRange(DeviceAddress addressesRangeToValidate[], uint8_t numberOfAddresses, int8_t mapedPositions[]);
+	void mapIndexPositionOfDeviceAddressRange(NonBlockingDallasQuery &query, int8_t mapedPositions[]);
+
+protected:
+	struct sensorStorage
+	{
+		uint8_t capacity;
+		uint16_t lookupSize; // Power of two, see nbdLookupSize()
+		int32_t *temperatures;
+		DeviceAddress *addresses;
+		unsigned long *intervals;
+		unsigned long *dueMillis;
+		uint8_t *flags;
+		uint8_t *lookup;
+		uint8_t *validMask;	  // (capacity + 7) / 8 bytes
+		uint8_t *changedMask; // (capacity + 7) / 8 bytes
+	};
+
+	NonBlockingDallasBase(DallasTemperature *dallasTemp, OneWire *oneWire, const sensorStorage &storage);
 
 private:
 	enum sensorState
 	{
 		notFound = 0,
 		waitingNextReading,
+		requestingConversion,
 		waitingConversion,
+		searchingAlarms,
 		readingSensor
 	};
 
+	enum sensorFlag
+	{
+		flagPending = 0x01, // Conversion requested, waiting for the readout
+		flagSeen = 0x02,	// Found by the current discovery sweep
+		flagMissing = 0x04, // Not found by the last discovery sweep, skipped by conversions and readouts
+		flagAlarmDirty = 0x08, // TH/TL registers to be programmed from the thresholds
+		flagAlarmed = 0x10	   // Found by the alarm search after the last conversion
+	};
+
 	DallasTemperature *_dallasTemp;
+	OneWire *_oneWire;					// Bus used by the discovery, NULL disables it
+	NonBlockingDallasHistory *_history; // Receives the valid readings, NULL disables it
+	NonBlockingDallasEventQueue *_eventQueue; // Receives the events of the readout, NULL invokes the callbacks at once
+	NonBlockingDallasTrace *_trace; // Records or replays the bus operations, NULL disables it
+	NonBlockingDallasStats *_stats; // Counts the updates, cycles and failures, NULL disables it
+	NonBlockingDallasSnapshot *_snapshot; // Receives the temperatures at the end of each cycle, NULL disables it
+	NonBlockingDallasTimings *_timings; // Receives the conversion and readout times of each sensor, NULL disables it
+	NonBlockingDallasChangeFilter *_changeFilter; // Decides when a new reading is reported as a change, NULL reports any change
+	NonBlockingDallasThresholds *_thresholds; // User thresholds of each sensor, NULL for none
+	NonBlockingDallasAdaptive *_adaptive; // Interval and resolution of each sensor chosen by the adaptive modes, NULL disables them
+	NonBlockingDallasConversionTimes *_conversionTimes; // Learned conversion times of each sensor, NULL uses the datasheet ones
+	resolution _resolution;
 	sensorState _currentState;
 	uint8_t _sensorsCount;				  // Number of sensors found on the bus
 	unsigned long _lastReadingMillis;	  // Time at last temperature sensor readout
 	unsigned long _startConversionMillis; // Time at start conversion of the sensor
+	unsigned long _lastRequestMillis;	  // Time of the last conversion request of the cycle, the conversions end after it
 	unsigned long _conversionMillis;	  // Sensor conversion time based on the resolution [milliseconds]
+	uint8_t _readIndex;					  // Next sensor to read in the current readout
+	uint8_t _requestIndex;				  // Next sensor to address in the current conversion request
+	uint8_t _indexOffset;				  // Added to the deviceIndex passed to the callbacks
+	uint16_t _tableGeneration;			  // Changed each time the address table changes
+	uint8_t _sensorsPerUpdate;			  // Maximum sensors requested or read by each update() call, 0 for all
+	unsigned long _readBudgetMicros;	  // Request and readout time budget of each update() call, 0 disables it [microseconds]
 
-	unsigned long _tempInterval;			 // Interval among each sensor reading [milliseconds]
-	int32_t _temperatures[ONE_WIRE_MAX_DEV]; // Array of last valid temperature raw values
-	DeviceAddress _sensorAddresses[ONE_WIRE_MAX_DEV];
+	unsigned long _tempInterval; // Interval among each sensor reading [milliseconds]
+	unsigned long _mergeWindow;	 // Sensors due within this time join the current conversion [milliseconds]
+	bool _mergeWindowSet;		 // _mergeWindow comes from setMergeWindow(), begin() keeps it
+	uint8_t _capacity;			 // Size of the per-sensor arrays
+	uint8_t _lookupMask;		 // Size of _addressLookup minus one
+	int32_t *_temperatures;		 // Array of last valid temperature raw values
+	DeviceAddress *_sensorAddresses;
+	unsigned long *_sensorIntervals; // Interval of each sensor, 0 uses _tempInterval [milliseconds]
+	unsigned long *_sensorDueMillis; // Time of the next conversion of each sensor
+	uint8_t *_sensorFlags;			 // sensorFlag bits of each sensor
+	uint8_t *_addressLookup;		 // Open addressing hash of the addresses, sensor index + 1 or 0 when empty
+	uint8_t *_validMask;			 // Bit set for each sensor read successfully during the current cycle
+	uint8_t *_changedMask;			 // Bit set for each sensor whose temperature changed during the current cycle
+	unsigned long _minChangeInterval; // Minimum time among two changes reported for the same sensor [milliseconds]
+	unsigned long _adaptiveMinInterval; // Shortest adaptive interval, 0 disables the adaptive mode [milliseconds]
+	unsigned long _adaptiveMaxInterval; // Longest adaptive interval [milliseconds]
+	uint16_t _adaptiveStable;		   // Largest change among two readings considered stable [RAW]
+	uint16_t _adaptiveMargin;		   // Distance to a threshold where the shortest interval is used [RAW]
+	resolution _farResolution;		   // Resolution of the sensors far from their thresholds
+	resolution _nearResolution;		   // Resolution of the sensors near their thresholds
+	uint16_t _nearResolutionRAW;	   // Distance to a threshold where the near resolution is used, 0 disables the mode [RAW]
+	bool _restoreResolution;		   // The mode was turned off, the sensors go back to the begin() resolution
+	uint8_t _alarmSweepCycles;		   // Conversions among two full readouts in alarm mode, 0 disables the mode
+	uint8_t _alarmCycle;			   // Conversions since the last full readout
+	bool _timedWait;				   // Do not poll the bus before the expected end of the conversion
+	uint8_t _cycleResolution;		   // Finest resolution among the sensors converting [bits]
+	unsigned long _expectedConversionMillis; // Learned conversion time of the slowest sensor converting [milliseconds]
+	unsigned long _nextPollMillis;	   // Time of the next conversion poll in timed wait
+	unsigned long _pollStepMillis;	   // Time among the conversion polls, doubled after each one [milliseconds]
+	uint8_t _fullReadCycles;		   // Cycles among two CRC checked readouts in fast read, 0 disables the fast read
+	uint8_t _fastReadCycle;			   // Cycles since the last CRC checked readout
+	uint16_t _maxJump;				   // Largest change among two fast readings taken without a CRC check, 0 for any [RAW]
+	bool _skipRom;					   // Address the only sensor of the bus with Skip ROM
+	bool _singleDevice;				   // The last enumeration found exactly one device, the sensor of the table
+	uint8_t _sweepDevices;			   // Devices found by the discovery sweep in progress
+	uint32_t _cycleCount;			   // Conversion and readout cycles completed
+	bool _cacheUnverified;			   // The table comes from beginFromCache() and has not been read yet
+	bool _cacheFailed;				   // A sensor of the cached table did not answer to the first readout
+
+	uint8_t _discoveryBits;			   // ROM bits searched by each update() call, 0 disables the discovery
+	unsigned long _discoveryInterval;  // Interval among discovery sweeps [milliseconds]
+	bool _discoveryIntervalSet;		   // _discoveryInterval comes from setDiscovery(), begin() keeps it
+	unsigned long _lastSweepMillis;	   // Time at start of the last discovery sweep
+	bool _sweepRunning;				   // A discovery sweep is in progress
+	uint8_t _searchBit;				   // Next ROM bit of the current search pass, 0 starts a new pass
+	uint8_t _searchLastDiscrepancy;	   // Bit where the previous pass took the 0 branch last
+	uint8_t _searchLastZero;		   // Bit where the current pass took the 0 branch last
+	DeviceAddress _searchAddress;	   // ROM built by the current search pass
 
 	void waitNextReading();
+	void requestConversion(uint8_t pendingCount);
+	void requestSensors();
+	void startWaiting();
+	void discoverStep();
+	void addDiscoveredDevice(DeviceAddress deviceAddress);
+	void finishSweep();
+	void clearAddressLookup();
+	uint8_t addressLookupSlot(const DeviceAddress deviceAddress);
+	void addToAddressLookup(uint8_t deviceIndex);
+	void resolveQuery(NonBlockingDallasQuery &query);
 	void waitConversion();
 	void readSensors();
 	void readTemperatures(int deviceIndex);
+	bool filterChange(uint8_t deviceIndex, int32_t rawTemp);
+	unsigned long effectiveInterval(uint8_t deviceIndex);
+	void adaptInterval(uint8_t deviceIndex, int32_t rawTemp);
+	void adaptResolution(uint8_t deviceIndex, int32_t rawTemp);
+	void applyResolution(uint8_t deviceIndex, uint8_t bits);
+	uint8_t sensorResolution(uint8_t deviceIndex);
+	uint16_t sensorConversionMillis(uint8_t deviceIndex, uint8_t bits);
+	void sensorThresholds(uint8_t deviceIndex, int16_t &lowRAW, int16_t &highRAW);
+	bool programAlarms();
+	void searchAlarms();
+	void learnConversion(unsigned long measuredMillis);
+	static uint16_t resolutionMillis(uint8_t bits);
+	static int32_t scratchPadRAW(const uint8_t *scratchPad);
+	void countFailure(uint8_t deviceIndex);
+	int32_t readTemperatureRAW(uint8_t deviceIndex);
+	bool useSkipRom(uint8_t deviceIndex);
+	void scheduleChanged();
+	void emitEvent(uint8_t type, int deviceIndex, int32_t rawTemp);
+	void validateInterval();
+
+	// Bus operations, recorded or replayed by the attached trace
+	bool replaying();
+	void traceOperation(uint8_t op, bool result, unsigned long startMicros, uint8_t deviceIndex = 0xFF, int32_t value = 0, const uint8_t *data = NULL, uint8_t dataLength = 0);
+	uint8_t busEnumerate();
+	bool busGetAddress(uint8_t deviceIndex, DeviceAddress deviceAddress);
+	bool busReadPowerSupply();
+	bool busParasite();
+	bool busSetResolution(uint8_t deviceIndex, uint8_t bits);
+	void busSetAlarms(uint8_t deviceIndex, int8_t high, int8_t low);
+	void busRequest(uint8_t deviceIndex);
+	bool busConversionComplete();
+	int32_t busGetTemp(uint8_t deviceIndex);
+	bool busReadFast(uint8_t deviceIndex, int32_t &rawTemp);
+	bool busReadScratchPad(uint8_t deviceIndex, ScratchPad scratchPad);
+	void busResetAlarmSearch();
+	bool busAlarmSearch(DeviceAddress deviceAddress);
+	bool busSearchReset();
+	uint8_t busSearchBits();
+	void busSearchDirection(uint8_t direction);
 	void (*cb_onDeviceDisconnected)(int deviceIndex);
 	void (*cb_onIntervalElapsed)(int deviceIndex, int32_t temperatureRAW);	 // Invoked only if reading is valid. "valid" parameter will be removed in a future version
 	void (*cb_onTemperatureChange)(int deviceIndex, int32_t temperatureRAW); // Invoked only if reading is valid. "valid" parameter will be removed in a future version
+	void (*cb_onCycleComplete)(const int32_t *temperaturesRAW, uint8_t sensorsCount, const uint8_t *validMask, const uint8_t *changedMask);
+	void (*cb_onScheduleChange)(unsigned long millisToNextUpdate); // Invoked when a call outside update() brings the next update() forward
+};
+
+/**
+ * NonBlockingDallas handling up to CAPACITY sensors, from 1 to 127
+ */
+template <uint8_t CAPACITY>
+class NonBlockingDallasN : public NonBlockingDallasBase
+{
+	static_assert(CAPACITY > 0 && CAPACITY <= 127, "NonBlockingDallasN capacity must be between 1 and 127");
+
+public:
+	NonBlockingDallasN(DallasTemperature *dallasTemp, OneWire *oneWire = NULL)
+		: NonBlockingDallasBase(dallasTemp, oneWire, storage(this))
+	{
+	}
+
+private:
+	int32_t _temperatureSlots[CAPACITY];
+	DeviceAddress _addressSlots[CAPACITY];
+	unsigned long _intervalSlots[CAPACITY];
+	unsigned long _dueMillisSlots[CAPACITY];
+	uint8_t _flagSlots[CAPACITY];
+	uint8_t _lookupSlots[nbdLookupSize(CAPACITY)];
+	uint8_t _validMaskSlots[(CAPACITY + 7) / 8];
+	uint8_t _changedMaskSlots[(CAPACITY + 7) / 8];
+
+	// Runs before the base class is built, so it is static and only takes the addresses of the arrays of self
+	static sensorStorage storage(NonBlockingDallasN *self)
+	{
+		sensorStorage s;
+		s.capacity = CAPACITY;
+		s.lookupSize = nbdLookupSize(CAPACITY);
+		s.temperatures = self->_temperatureSlots;
+		s.addresses = self->_addressSlots;
+		s.intervals = self->_intervalSlots;
+		s.dueMillis = self->_dueMillisSlots;
+		s.flags = self->_flagSlots;
+		s.lookup = self->_lookupSlots;
+		s.validMask = self->_validMaskSlots;
+		s.changedMask = self->_changedMaskSlots;
+		return s;
+	}
+};
+
+/**
+ * NonBlockingDallas handling up to ONE_WIRE_MAX_DEV sensors
+ */
+class NonBlockingDallas : public NonBlockingDallasN<ONE_WIRE_MAX_DEV>
+{
+public:
+	NonBlockingDallas(DallasTemperature *dallasTemp, OneWire *oneWire = NULL)
+		: NonBlockingDallasN<ONE_WIRE_MAX_DEV>(dallasTemp, oneWire)
+	{
+	}
 };
 
 #endif
\ No newline at end of file
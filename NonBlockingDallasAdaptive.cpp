@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasAdaptive.h"
+
+NonBlockingDallasAdaptive::NonBlockingDallasAdaptive(sensorAdaptive *sensors, uint8_t count)
+{
+	_sensors = sensors;
+	_count = count;
+	for (uint8_t i = 0; i < _count; i++)
+	{
+		_sensors[i].interval = 0;
+		_sensors[i].resolution = 12;
+		_sensors[i].hold = 0;
+	}
+}
+
+/**
+ * @return interval of the sensor [milliseconds], 0 if not adapted or beyond the adaptive state
+ */
+unsigned long NonBlockingDallasAdaptive::getInterval(uint8_t deviceIndex)
+{
+	return deviceIndex < _count ? _sensors[deviceIndex].interval : 0;
+}
+
+void NonBlockingDallasAdaptive::setInterval(uint8_t deviceIndex, unsigned long interval)
+{
+	if (deviceIndex < _count)
+		_sensors[deviceIndex].interval = interval;
+}
+
+void NonBlockingDallasAdaptive::setIntervalAll(unsigned long interval)
+{
+	for (uint8_t i = 0; i < _count; i++)
+		_sensors[i].interval = interval;
+}
+
+/**
+ * @return resolution of the sensor [bits], 0 if beyond the adaptive state
+ */
+uint8_t NonBlockingDallasAdaptive::getResolution(uint8_t deviceIndex)
+{
+	return deviceIndex < _count ? _sensors[deviceIndex].resolution : 0;
+}
+
+void NonBlockingDallasAdaptive::setResolution(uint8_t deviceIndex, uint8_t bits)
+{
+	if (deviceIndex < _count)
+		_sensors[deviceIndex].resolution = bits;
+}
+
+uint8_t NonBlockingDallasAdaptive::getHold(uint8_t deviceIndex)
+{
+	return deviceIndex < _count ? _sensors[deviceIndex].hold : 0;
+}
+
+void NonBlockingDallasAdaptive::setHold(uint8_t deviceIndex, uint8_t readings)
+{
+	if (deviceIndex < _count)
+		_sensors[deviceIndex].hold = readings;
+}
+
+uint8_t NonBlockingDallasAdaptive::getSensors()
+{
+	return _count;
+}
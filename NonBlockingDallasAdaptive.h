@@ -0,0 +1,79 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasAdaptive_h
+#define NonBlockingDallasAdaptive_h
+
+#include <Arduino.h>
+
+/**
+ * Interval and resolution chosen for each sensor by the adaptive modes. Once attached to NonBlockingDallas
+ * it is updated by update() after each reading, as set by setAdaptiveInterval() and setAdaptiveResolution().
+ * The storage is provided by NonBlockingDallasAdaptiveN
+ */
+class NonBlockingDallasAdaptive
+{
+
+public:
+	unsigned long getInterval(uint8_t deviceIndex);
+	void setInterval(uint8_t deviceIndex, unsigned long interval);
+	void setIntervalAll(unsigned long interval);
+	uint8_t getResolution(uint8_t deviceIndex);
+	void setResolution(uint8_t deviceIndex, uint8_t bits);
+	uint8_t getHold(uint8_t deviceIndex);
+	void setHold(uint8_t deviceIndex, uint8_t readings);
+	uint8_t getSensors();
+
+protected:
+	struct sensorAdaptive
+	{
+		unsigned long interval; // Interval chosen by the adaptive interval, 0 if not adapted yet [milliseconds]
+		uint8_t resolution;		// Resolution of the sensor [bits]
+		uint8_t hold;			// Readings left before the sensor can go back to the far resolution
+	};
+
+	NonBlockingDallasAdaptive(sensorAdaptive *sensors, uint8_t count);
+
+private:
+	sensorAdaptive *_sensors;
+	uint8_t _count;
+};
+
+/**
+ * Adaptive state of up to SENSORS sensors, sensors beyond it keep the begin() interval and resolution
+ */
+template <uint8_t SENSORS>
+class NonBlockingDallasAdaptiveN : public NonBlockingDallasAdaptive
+{
+	static_assert(SENSORS > 0, "NonBlockingDallasAdaptiveN needs at least one sensor");
+
+public:
+	NonBlockingDallasAdaptiveN()
+		: NonBlockingDallasAdaptive(_sensorSlots, SENSORS)
+	{
+	}
+
+private:
+	sensorAdaptive _sensorSlots[SENSORS];
+};
+
+#endif
@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasChangeFilter.h"
+#include <DallasTemperature.h>
+
+NonBlockingDallasChangeFilter::NonBlockingDallasChangeFilter(changeFilter *filters, uint8_t sensors)
+{
+	_filters = filters;
+	_sensors = sensors;
+	for (uint8_t i = 0; i < _sensors; i++)
+	{
+		_filters[i].deadband = 0;
+		_filters[i].hysteresis = 0;
+		_filters[i].lastChangeMillis = 0;
+		reset(i);
+	}
+}
+
+/**
+ * @brief Set the deadband and the hysteresis of a sensor, 0 and 0 report any change
+ *
+ * @return false if the sensor is beyond the filter
+ */
+bool NonBlockingDallasChangeFilter::setFilter(uint8_t deviceIndex, uint16_t deadbandRAW, uint16_t hysteresisRAW)
+{
+	if (deviceIndex >= _sensors)
+		return false;
+	_filters[deviceIndex].deadband = deadbandRAW;
+	_filters[deviceIndex].hysteresis = hysteresisRAW;
+	return true;
+}
+
+void NonBlockingDallasChangeFilter::setFilterAll(uint16_t deadbandRAW, uint16_t hysteresisRAW)
+{
+	for (uint8_t i = 0; i < _sensors; i++)
+		setFilter(i, deadbandRAW, hysteresisRAW);
+}
+
+/**
+ * A reading is reported as a change when it moves away from the last reported value by more than the
+ * deadband, plus the hysteresis when it goes back in the opposite direction. The first valid reading
+ * is always reported
+ *
+ * @param minChangeInterval minimum time since the last reported change [milliseconds], 0 disables it
+ * @return true if the reading is reported, invoked by NonBlockingDallas with each valid reading
+ */
+bool NonBlockingDallasChangeFilter::filter(uint8_t deviceIndex, int32_t rawTemp, unsigned long nowMillis, unsigned long minChangeInterval)
+{
+	if (deviceIndex >= _sensors)
+		return true;
+	changeFilter &filter = _filters[deviceIndex];
+
+	if (filter.reportedRAW != DEVICE_DISCONNECTED_RAW)
+	{
+		int32_t delta = rawTemp - filter.reportedRAW;
+		int8_t direction = delta > 0 ? 1 : -1;
+		int32_t threshold = filter.deadband;
+
+		if (filter.direction != 0 && direction != filter.direction)
+			threshold += filter.hysteresis;
+		if ((delta >= 0 ? delta : -delta) <= threshold)
+			return false;
+		if (minChangeInterval > 0 && nowMillis - filter.lastChangeMillis < minChangeInterval)
+			return false;
+		filter.direction = direction;
+	}
+
+	filter.reportedRAW = rawTemp;
+	filter.lastChangeMillis = nowMillis;
+	return true;
+}
+
+/**
+ * @brief Forget the last reported value of a sensor, its next reading is reported. The deadband is kept
+ */
+void NonBlockingDallasChangeFilter::reset(uint8_t deviceIndex)
+{
+	if (deviceIndex >= _sensors)
+		return;
+	_filters[deviceIndex].reportedRAW = DEVICE_DISCONNECTED_RAW;
+	_filters[deviceIndex].direction = 0;
+}
+
+uint8_t NonBlockingDallasChangeFilter::getSensors()
+{
+	return _sensors;
+}
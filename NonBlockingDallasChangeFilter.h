@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasChangeFilter_h
+#define NonBlockingDallasChangeFilter_h
+
+#include <Arduino.h>
+
+/**
+ * Deadband and hysteresis of each sensor, deciding which readings invoke onTemperatureChange.
+ * Once attached to NonBlockingDallas it is set by setChangeFilter() and setChangeFilterAll()
+ * and consulted by update(). The storage is provided by NonBlockingDallasChangeFilterN
+ */
+class NonBlockingDallasChangeFilter
+{
+
+public:
+	bool setFilter(uint8_t deviceIndex, uint16_t deadbandRAW, uint16_t hysteresisRAW);
+	void setFilterAll(uint16_t deadbandRAW, uint16_t hysteresisRAW);
+	bool filter(uint8_t deviceIndex, int32_t rawTemp, unsigned long nowMillis, unsigned long minChangeInterval);
+	void reset(uint8_t deviceIndex);
+	uint8_t getSensors();
+
+protected:
+	struct changeFilter
+	{
+		int32_t reportedRAW;			// Temperature passed to the last onTemperatureChange
+		uint16_t deadband;				// Change needed to report again [RAW]
+		uint16_t hysteresis;			// Extra change needed to report a change of direction [RAW]
+		int8_t direction;				// Sign of the last reported change
+		unsigned long lastChangeMillis; // Time of the last reported change
+	};
+
+	NonBlockingDallasChangeFilter(changeFilter *filters, uint8_t sensors);
+
+private:
+	changeFilter *_filters;
+	uint8_t _sensors;
+};
+
+/**
+ * Change filter of up to SENSORS sensors, sensors beyond it report any change
+ */
+template <uint8_t SENSORS>
+class NonBlockingDallasChangeFilterN : public NonBlockingDallasChangeFilter
+{
+	static_assert(SENSORS > 0, "NonBlockingDallasChangeFilterN needs at least one sensor");
+
+public:
+	NonBlockingDallasChangeFilterN()
+		: NonBlockingDallasChangeFilter(_filterSlots, SENSORS)
+	{
+	}
+
+private:
+	changeFilter _filterSlots[SENSORS];
+};
+
+#endif
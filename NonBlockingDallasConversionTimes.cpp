@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasConversionTimes.h"
+
+NonBlockingDallasConversionTimes::NonBlockingDallasConversionTimes(sensorTimes *times, uint8_t sensors)
+{
+	_times = times;
+	_sensors = sensors;
+	for (uint8_t i = 0; i < _sensors; i++)
+		reset(i);
+}
+
+/**
+ * @return learned conversion time of the sensor at the resolution [milliseconds], 0 if not learned yet
+ */
+uint16_t NonBlockingDallasConversionTimes::getMillis(uint8_t deviceIndex, uint8_t bits)
+{
+	if (deviceIndex >= _sensors || bits < 9 || bits > 12)
+		return 0;
+	return _times[deviceIndex][bits - 9];
+}
+
+void NonBlockingDallasConversionTimes::setMillis(uint8_t deviceIndex, uint8_t bits, uint16_t conversionMillis)
+{
+	if (deviceIndex < _sensors && bits >= 9 && bits <= 12)
+		_times[deviceIndex][bits - 9] = conversionMillis;
+}
+
+/**
+ * @brief Forget the times learned for a sensor, the datasheet times are used again
+ */
+void NonBlockingDallasConversionTimes::reset(uint8_t deviceIndex)
+{
+	for (uint8_t bits = 9; bits <= 12; bits++)
+		setMillis(deviceIndex, bits, 0);
+}
+
+uint8_t NonBlockingDallasConversionTimes::getSensors()
+{
+	return _sensors;
+}
@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasConversionTimes_h
+#define NonBlockingDallasConversionTimes_h
+
+#include <Arduino.h>
+
+/**
+ * Conversion time of each sensor at 9..12 bits, learned from the measured completions. Once attached
+ * to NonBlockingDallas it is updated by update() and followed by the timed wait.
+ * The storage is provided by NonBlockingDallasConversionTimesN
+ */
+class NonBlockingDallasConversionTimes
+{
+
+public:
+	uint16_t getMillis(uint8_t deviceIndex, uint8_t bits);
+	void setMillis(uint8_t deviceIndex, uint8_t bits, uint16_t conversionMillis);
+	void reset(uint8_t deviceIndex);
+	uint8_t getSensors();
+
+protected:
+	typedef uint16_t sensorTimes[4]; // At 9..12 bits, 0 if not learned [milliseconds]
+
+	NonBlockingDallasConversionTimes(sensorTimes *times, uint8_t sensors);
+
+private:
+	sensorTimes *_times;
+	uint8_t _sensors;
+};
+
+/**
+ * Conversion times of up to SENSORS sensors, sensors beyond it use the datasheet times
+ */
+template <uint8_t SENSORS>
+class NonBlockingDallasConversionTimesN : public NonBlockingDallasConversionTimes
+{
+	static_assert(SENSORS > 0, "NonBlockingDallasConversionTimesN needs at least one sensor");
+
+public:
+	NonBlockingDallasConversionTimesN()
+		: NonBlockingDallasConversionTimes(_timeSlots, SENSORS)
+	{
+	}
+
+private:
+	sensorTimes _timeSlots[SENSORS];
+};
+
+#endif
@@ -0,0 +1,164 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasEventQueue.h"
+#include "NonBlockingDallas.h" // NBD_MEMORY_BARRIER()
+
+NonBlockingDallasEventQueue::NonBlockingDallasEventQueue(event *slots, uint8_t size)
+{
+	_slots = slots;
+	_size = size;
+	_wrap = 0x80000000UL / size * size; // A multiple of size, a position keeps its slot when it wraps
+	_head = 0;
+	_tail = 0;
+	_claimed = 0;
+	_policy = dropOldest;
+	resetCounters();
+}
+
+/**
+ * @brief Add an event, invoked by NonBlockingDallas during the readout
+ *
+ * With dropOldest a full queue is overwritten, pop() skips the events overwritten.
+ *
+ * @return false if an event has been dropped
+ */
+bool NonBlockingDallasEventQueue::push(uint8_t type, uint16_t deviceIndex, int32_t temperatureRAW)
+{
+	uint32_t tail = _tail;
+	uint32_t count = distance(_head, tail);
+	bool full = count >= _size;
+	if (full)
+	{
+		_dropped++;
+		if (_policy == dropNewest)
+			return false;
+	}
+
+	// The slot is announced before it is written, so that pop() can tell a copy overwritten meanwhile
+	_claimed = advance(tail, 1);
+	NBD_MEMORY_BARRIER();
+	event &e = _slots[tail % _size];
+	e.type = type;
+	e.deviceIndex = deviceIndex;
+	e.temperatureRAW = temperatureRAW;
+	NBD_MEMORY_BARRIER();
+	_tail = advance(tail, 1);
+
+	if (count < _size && count + 1 > _highWater)
+		_highWater = count + 1;
+	return !full;
+}
+
+/**
+ * @brief Remove the oldest event
+ *
+ * @return false if the queue is empty
+ */
+bool NonBlockingDallasEventQueue::pop(event &e)
+{
+	for (;;)
+	{
+		uint32_t head = _head;
+		uint32_t tail = _tail;
+		NBD_MEMORY_BARRIER();
+		uint32_t count = distance(head, tail);
+		if (count == 0)
+			return false;
+
+		// The slot of head is written again by the position head + _size
+		if (count <= _size)
+		{
+			e = _slots[head % _size];
+			NBD_MEMORY_BARRIER();
+			if (distance(head, _claimed) <= _size)
+			{
+				_head = advance(head, 1);
+				return true;
+			}
+			tail = _tail;
+		}
+
+		// Overwritten by dropOldest, resume from the oldest event still in the queue
+		_head = advance(tail, _wrap - _size);
+	}
+}
+
+/**
+ * @brief Discard all the events, call it from the context of dispatch()
+ */
+void NonBlockingDallasEventQueue::clear()
+{
+	_head = _tail;
+}
+
+void NonBlockingDallasEventQueue::setOverflowPolicy(overflowPolicy policy)
+{
+	_policy = policy;
+}
+
+uint8_t NonBlockingDallasEventQueue::getSize()
+{
+	return _size;
+}
+
+uint8_t NonBlockingDallasEventQueue::getCount()
+{
+	uint32_t count = distance(_head, _tail);
+	return count < _size ? count : _size;
+}
+
+/**
+ * @brief Largest number of events waiting since the last resetCounters(), to size the queue
+ */
+uint8_t NonBlockingDallasEventQueue::getHighWater()
+{
+	return _highWater;
+}
+
+/**
+ * @brief Events lost because the queue was full since the last resetCounters()
+ *
+ * With dropOldest and a consumer on another core, an event popped while push() overwrites it
+ * may be counted too.
+ */
+uint32_t NonBlockingDallasEventQueue::getDropped()
+{
+	return _dropped;
+}
+
+void NonBlockingDallasEventQueue::resetCounters()
+{
+	_highWater = getCount();
+	_dropped = 0;
+}
+
+// Positions ahead of from, modulo _wrap
+uint32_t NonBlockingDallasEventQueue::distance(uint32_t from, uint32_t to)
+{
+	return to >= from ? to - from : to + (_wrap - from);
+}
+
+uint32_t NonBlockingDallasEventQueue::advance(uint32_t position, uint32_t steps)
+{
+	return (position + steps) % _wrap;
+}
@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasEventQueue_h
+#define NonBlockingDallasEventQueue_h
+
+#include <Arduino.h>
+
+/**
+ * Bounded ring buffer of the events of the readout. Once attached to NonBlockingDallas the
+ * readout only stores the events, the callbacks are invoked later by dispatch().
+ * One producer, update(), and one consumer, dispatch(), may run on different cores or tasks of a
+ * 32 bit board: each one only writes its own position. On 8 bit boards the positions are not read
+ * atomically, update() and dispatch() must run in the same context. The storage is provided by
+ * NonBlockingDallasEventQueueN
+ */
+class NonBlockingDallasEventQueue
+{
+
+public:
+	enum eventType
+	{
+		intervalElapsed = 0,
+		temperatureChange,
+		deviceDisconnected
+	};
+
+	enum overflowPolicy
+	{
+		dropOldest = 0, // A new event replaces the oldest one
+		dropNewest		// A new event is discarded
+	};
+
+	struct event
+	{
+		uint8_t type;			// eventType
+		uint16_t deviceIndex;	// Index passed to the callbacks, with the offset of the bus
+		int32_t temperatureRAW; // DEVICE_DISCONNECTED_RAW for deviceDisconnected
+	};
+
+	bool push(uint8_t type, uint16_t deviceIndex, int32_t temperatureRAW);
+	bool pop(event &e);
+	void clear();
+	void setOverflowPolicy(overflowPolicy policy);
+
+	uint8_t getSize();
+	uint8_t getCount();
+	uint8_t getHighWater();
+	uint32_t getDropped();
+	void resetCounters();
+
+protected:
+	NonBlockingDallasEventQueue(event *slots, uint8_t size);
+
+private:
+	event *_slots;
+	uint8_t _size;
+	uint32_t _wrap;				 // Positions count modulo this multiple of _size
+	volatile uint32_t _head;	 // Position of the oldest event, written by pop() only
+	volatile uint32_t _tail;	 // Position of the next event, written by push() only
+	volatile uint32_t _claimed;	 // Position after the one push() is writing, written by push() only
+	uint8_t _highWater;			 // Largest count since the last resetCounters()
+	uint32_t _dropped;			 // Events lost by overflow since the last resetCounters()
+	overflowPolicy _policy;
+
+	uint32_t distance(uint32_t from, uint32_t to);
+	uint32_t advance(uint32_t position, uint32_t steps);
+};
+
+/**
+ * Event queue holding up to SIZE events
+ */
+template <uint8_t SIZE>
+class NonBlockingDallasEventQueueN : public NonBlockingDallasEventQueue
+{
+	static_assert(SIZE > 0, "NonBlockingDallasEventQueueN needs at least one slot");
+
+public:
+	NonBlockingDallasEventQueueN()
+		: NonBlockingDallasEventQueue(_eventSlots, SIZE)
+	{
+	}
+
+private:
+	event _eventSlots[SIZE];
+};
+
+#endif
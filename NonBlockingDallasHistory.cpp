@@ -0,0 +1,241 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasHistory.h"
+#include <DallasTemperature.h>
+
+NonBlockingDallasHistory::NonBlockingDallasHistory(const historyStorage &storage)
+{
+	_sensors = storage.sensors;
+	_depth = storage.depth;
+	_emaShift = DEFAULT_EMA_SHIFT;
+	_samples = storage.samples;
+	_minQueue = storage.minQueue;
+	_maxQueue = storage.maxQueue;
+	_stats = storage.stats;
+	resetAll();
+}
+
+/**
+ * @brief Add a reading to the history of a sensor, invoked by NonBlockingDallas for each valid reading
+ *
+ * Min and max are kept by two monotonic queues of slots, so no sample of the window is scanned again.
+ */
+void NonBlockingDallasHistory::push(uint8_t deviceIndex, int32_t temperatureRAW, unsigned long timeMillis)
+{
+	if (deviceIndex >= _sensors)
+		return;
+
+	sensorHistory &h = _stats[deviceIndex];
+	int16_t *samples = &_samples[deviceIndex * _depth];
+	uint8_t *minQueue = &_minQueue[deviceIndex * _depth];
+	uint8_t *maxQueue = &_maxQueue[deviceIndex * _depth];
+	int16_t value = (int16_t)temperatureRAW;
+
+	if (h.count > 0)
+	{
+		unsigned long elapsed = timeMillis - h.lastMillis;
+		if (elapsed > 0)
+			h.rate = (int32_t)(((int32_t)value - samples[(h.head + _depth - 1) % _depth]) * 60000L / (long)elapsed);
+		h.ema += (((int32_t)value << 8) - h.ema) >> _emaShift;
+	}
+	else
+		h.ema = (int32_t)value << 8;
+	h.lastMillis = timeMillis;
+
+	// The oldest sample leaves the window, and the queues if it is at their front
+	if (h.count == _depth)
+	{
+		h.sum -= samples[h.head];
+		if (h.minCount > 0 && minQueue[h.minHead] == h.head)
+		{
+			h.minHead = (h.minHead + 1) % _depth;
+			h.minCount--;
+		}
+		if (h.maxCount > 0 && maxQueue[h.maxHead] == h.head)
+		{
+			h.maxHead = (h.maxHead + 1) % _depth;
+			h.maxCount--;
+		}
+	}
+	else
+		h.count++;
+
+	samples[h.head] = value;
+	h.sum += value;
+
+	// Samples that can no longer be the min or the max are dropped from the back of the queues
+	while (h.minCount > 0 && samples[minQueue[(h.minHead + h.minCount - 1) % _depth]] >= value)
+		h.minCount--;
+	minQueue[(h.minHead + h.minCount) % _depth] = h.head;
+	h.minCount++;
+
+	while (h.maxCount > 0 && samples[maxQueue[(h.maxHead + h.maxCount - 1) % _depth]] <= value)
+		h.maxCount--;
+	maxQueue[(h.maxHead + h.maxCount) % _depth] = h.head;
+	h.maxCount++;
+
+	h.head = (h.head + 1) % _depth;
+}
+
+/**
+ * @brief Clear the history of a sensor
+ */
+void NonBlockingDallasHistory::reset(uint8_t deviceIndex)
+{
+	if (deviceIndex >= _sensors)
+		return;
+
+	sensorHistory &h = _stats[deviceIndex];
+	h.head = 0;
+	h.count = 0;
+	h.minHead = 0;
+	h.minCount = 0;
+	h.maxHead = 0;
+	h.maxCount = 0;
+	h.sum = 0;
+	h.ema = 0;
+	h.rate = 0;
+	h.lastMillis = 0;
+}
+
+/**
+ * @brief Clear the history of all the sensors
+ */
+void NonBlockingDallasHistory::resetAll()
+{
+	for (uint8_t i = 0; i < _sensors; i++)
+		reset(i);
+}
+
+/**
+ * @brief Set the weight of a new sample in the exponential moving average
+ *
+ * @param shift weight is 1 / 2^shift, from 0 (last sample only) to 15
+ */
+void NonBlockingDallasHistory::setEmaShift(uint8_t shift)
+{
+	_emaShift = shift > 15 ? 15 : shift;
+}
+
+/**
+ * @brief Get the number of samples kept for each sensor
+ */
+uint8_t NonBlockingDallasHistory::getDepth()
+{
+	return _depth;
+}
+
+/**
+ * @brief Get the number of samples in the window of a sensor
+ */
+uint8_t NonBlockingDallasHistory::getSampleCount(uint8_t deviceIndex)
+{
+	if (deviceIndex >= _sensors)
+		return 0;
+	return _stats[deviceIndex].count;
+}
+
+/**
+ * @brief Get a sample of the window
+ *
+ * @param age 0 for the last reading, 1 for the previous one...
+ * @return DEVICE_DISCONNECTED_RAW if the sample does not exist
+ */
+int32_t NonBlockingDallasHistory::getSample(uint8_t deviceIndex, uint8_t age)
+{
+	if (deviceIndex >= _sensors || age >= _stats[deviceIndex].count)
+		return DEVICE_DISCONNECTED_RAW;
+	return _samples[deviceIndex * _depth + (_stats[deviceIndex].head + _depth - 1 - age) % _depth];
+}
+
+/**
+ * @brief Get the lowest RAW temperature of the window
+ *
+ * @return DEVICE_DISCONNECTED_RAW if there are no samples
+ */
+int32_t NonBlockingDallasHistory::getMin(uint8_t deviceIndex)
+{
+	if (!hasSamples(deviceIndex))
+		return DEVICE_DISCONNECTED_RAW;
+	return _samples[deviceIndex * _depth + _minQueue[deviceIndex * _depth + _stats[deviceIndex].minHead]];
+}
+
+/**
+ * @brief Get the highest RAW temperature of the window
+ *
+ * @return DEVICE_DISCONNECTED_RAW if there are no samples
+ */
+int32_t NonBlockingDallasHistory::getMax(uint8_t deviceIndex)
+{
+	if (!hasSamples(deviceIndex))
+		return DEVICE_DISCONNECTED_RAW;
+	return _samples[deviceIndex * _depth + _maxQueue[deviceIndex * _depth + _stats[deviceIndex].maxHead]];
+}
+
+/**
+ * @brief Get the mean RAW temperature of the window, rounded
+ *
+ * @return DEVICE_DISCONNECTED_RAW if there are no samples
+ */
+int32_t NonBlockingDallasHistory::getMean(uint8_t deviceIndex)
+{
+	if (!hasSamples(deviceIndex))
+		return DEVICE_DISCONNECTED_RAW;
+
+	int32_t sum = _stats[deviceIndex].sum;
+	int32_t count = _stats[deviceIndex].count;
+	return (sum >= 0 ? sum + count / 2 : sum - count / 2) / count;
+}
+
+/**
+ * @brief Get the exponential moving average of the RAW temperature, from the first reading on
+ *
+ * @return DEVICE_DISCONNECTED_RAW if there are no samples
+ */
+int32_t NonBlockingDallasHistory::getEMA(uint8_t deviceIndex)
+{
+	if (!hasSamples(deviceIndex))
+		return DEVICE_DISCONNECTED_RAW;
+	return (_stats[deviceIndex].ema + 128) >> 8;
+}
+
+/**
+ * @brief Get the rate of change between the last two readings
+ *
+ * @return int32_t RAW per minute, 0 with less than two readings
+ */
+int32_t NonBlockingDallasHistory::getRate(uint8_t deviceIndex)
+{
+	if (!hasSamples(deviceIndex))
+		return 0;
+	return _stats[deviceIndex].rate;
+}
+
+//==============================================================================================
+//									PRIVATE
+//==============================================================================================
+
+bool NonBlockingDallasHistory::hasSamples(uint8_t deviceIndex)
+{
+	return deviceIndex < _sensors && _stats[deviceIndex].count > 0;
+}
@@ -0,0 +1,125 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasHistory_h
+#define NonBlockingDallasHistory_h
+
+#include <Arduino.h>
+#define DEFAULT_EMA_SHIFT 3 // EMA weight of a new sample is 1/8
+
+/**
+ * Ring buffer of the last readings of each sensor with running statistics.
+ * All the statistics are updated on each reading and read in constant time,
+ * the storage is provided by NonBlockingDallasHistoryN
+ */
+class NonBlockingDallasHistory
+{
+
+public:
+	void push(uint8_t deviceIndex, int32_t temperatureRAW, unsigned long timeMillis);
+	void reset(uint8_t deviceIndex);
+	void resetAll();
+	void setEmaShift(uint8_t shift);
+
+	uint8_t getDepth();
+	uint8_t getSampleCount(uint8_t deviceIndex);
+	int32_t getSample(uint8_t deviceIndex, uint8_t age);
+	int32_t getMin(uint8_t deviceIndex);
+	int32_t getMax(uint8_t deviceIndex);
+	int32_t getMean(uint8_t deviceIndex);
+	int32_t getEMA(uint8_t deviceIndex);
+	int32_t getRate(uint8_t deviceIndex);
+
+protected:
+	struct sensorHistory
+	{
+		uint8_t head;		// Slot written by the next sample
+		uint8_t count;		// Samples in the window
+		uint8_t minHead;	// First slot of the min queue
+		uint8_t minCount;	// Slots in the min queue
+		uint8_t maxHead;	// First slot of the max queue
+		uint8_t maxCount;	// Slots in the max queue
+		int32_t sum;		// Sum of the samples in the window
+		int32_t ema;		// Exponential moving average, 8 fractional bits
+		int32_t rate;		// Change between the last two samples [RAW per minute]
+		unsigned long lastMillis; // Time of the last sample
+	};
+
+	struct historyStorage
+	{
+		uint8_t sensors;
+		uint8_t depth;
+		int16_t *samples;	// depth samples per sensor
+		uint8_t *minQueue;	// depth slots per sensor, increasing values
+		uint8_t *maxQueue;	// depth slots per sensor, decreasing values
+		sensorHistory *stats;
+	};
+
+	NonBlockingDallasHistory(const historyStorage &storage);
+
+private:
+	uint8_t _sensors;
+	uint8_t _depth;
+	uint8_t _emaShift; // EMA weight of a new sample is 1 / 2^_emaShift
+	int16_t *_samples;
+	uint8_t *_minQueue;
+	uint8_t *_maxQueue;
+	sensorHistory *_stats;
+
+	bool hasSamples(uint8_t deviceIndex);
+};
+
+/**
+ * History of SENSORS sensors keeping the last DEPTH readings of each one
+ */
+template <uint8_t SENSORS, uint8_t DEPTH>
+class NonBlockingDallasHistoryN : public NonBlockingDallasHistory
+{
+	static_assert(SENSORS > 0 && DEPTH > 0, "NonBlockingDallasHistoryN needs at least one sensor and one sample");
+
+public:
+	NonBlockingDallasHistoryN()
+		: NonBlockingDallasHistory(storage(this))
+	{
+	}
+
+private:
+	int16_t _sampleSlots[SENSORS * DEPTH];
+	uint8_t _minQueueSlots[SENSORS * DEPTH];
+	uint8_t _maxQueueSlots[SENSORS * DEPTH];
+	sensorHistory _statSlots[SENSORS];
+
+	// Runs before the base class is built, so it is static and only takes the addresses of the arrays of self
+	static historyStorage storage(NonBlockingDallasHistoryN *self)
+	{
+		historyStorage s;
+		s.sensors = SENSORS;
+		s.depth = DEPTH;
+		s.samples = self->_sampleSlots;
+		s.minQueue = self->_minQueueSlots;
+		s.maxQueue = self->_maxQueueSlots;
+		s.stats = self->_statSlots;
+		return s;
+	}
+};
+
+#endif
@@ -0,0 +1,349 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasManager.h"
+
+NonBlockingDallasManager::NonBlockingDallasManager()
+{
+	_busCount = 0;
+	_nextBus = 0;
+	_beginMillis = 0;
+	_startOffset = 0;
+	cb_onIntervalElapsed = NULL;
+	cb_onTemperatureChange = NULL;
+	cb_onDeviceDisconnected = NULL;
+	cb_onScheduleChange = NULL;
+	for (int i = 0; i < MANAGER_MAX_BUSES; i++)
+	{
+		_buses[i] = NULL;
+		_busStarted[i] = false;
+	}
+}
+
+/**
+ * @brief Add a bus to the manager, must be called before begin()
+ *
+ * The bus owns the indexes from the sum of the capacities of the buses added before it, so that
+ * a sensor discovered on a bus never shifts the indexes of the other buses.
+ *
+ * @return false if the manager is full or the capacities add up to more than 127 indexes
+ */
+bool NonBlockingDallasManager::addBus(NonBlockingDallasBase *bus)
+{
+	if (_busCount >= MANAGER_MAX_BUSES || getCapacity() + bus->getCapacity() > 127)
+		return false;
+
+	bus->setIndexOffset(getCapacity());
+	_buses[_busCount++] = bus;
+	bus->onIntervalElapsed(cb_onIntervalElapsed);
+	bus->onTemperatureChange(cb_onTemperatureChange);
+	bus->onDeviceDisconnected(cb_onDeviceDisconnected);
+	bus->onScheduleChange(cb_onScheduleChange);
+	return true;
+}
+
+/**
+ * @brief Initialize all the buses
+ *
+ * The first conversion of each bus is delayed by a fraction of the interval,
+ * so that one bus is read while the others are converting.
+ */
+void NonBlockingDallasManager::begin(NonBlockingDallas::resolution res, unsigned long tempInterval)
+{
+	for (int i = 0; i < _busCount; i++)
+	{
+		_buses[i]->begin(res, tempInterval);
+		_busStarted[i] = false;
+	}
+
+	_startOffset = _busCount > 0 ? tempInterval / _busCount : 0;
+	_beginMillis = NBD_MILLIS();
+}
+
+void NonBlockingDallasManager::update()
+{
+	bool readoutDone = false;
+
+	for (int n = 0; n < _busCount; n++)
+	{
+		uint8_t i = (_nextBus + n) % _busCount;
+
+		if (!_busStarted[i])
+		{
+			if (NBD_MILLIS() - _beginMillis < _startOffset * i)
+				continue;
+			_busStarted[i] = true;
+		}
+
+		// Only one bus is read per update(), the others keep their readout for the next calls
+		if (_buses[i]->isReadoutPending())
+		{
+			if (readoutDone)
+				continue;
+			readoutDone = true;
+		}
+
+		_buses[i]->update();
+	}
+
+	if (_busCount > 0)
+		_nextBus = (_nextBus + 1) % _busCount;
+}
+
+/**
+ * @brief Request a new reading of all the sensors on all the buses
+ */
+void NonBlockingDallasManager::requestTemperature()
+{
+	for (int i = 0; i < _busCount; i++)
+	{
+		_busStarted[i] = true;
+		_buses[i]->requestTemperature();
+	}
+}
+
+void NonBlockingDallasManager::onIntervalElapsed(void (*callback)(int deviceIndex, int32_t temperatureRAW))
+{
+	cb_onIntervalElapsed = callback;
+	for (int i = 0; i < _busCount; i++)
+		_buses[i]->onIntervalElapsed(callback);
+}
+
+void NonBlockingDallasManager::onTemperatureChange(void (*callback)(int deviceIndex, int32_t temperatureRAW))
+{
+	cb_onTemperatureChange = callback;
+	for (int i = 0; i < _busCount; i++)
+		_buses[i]->onTemperatureChange(callback);
+}
+
+void NonBlockingDallasManager::onDeviceDisconnected(void (*callback)(int deviceIndex))
+{
+	cb_onDeviceDisconnected = callback;
+	for (int i = 0; i < _busCount; i++)
+		_buses[i]->onDeviceDisconnected(callback);
+}
+
+/**
+ * @brief The callback receives the time to the next update() of the bus whose schedule changed,
+ * the caller may wake earlier than needed but never later
+ */
+void NonBlockingDallasManager::onScheduleChange(void (*callback)(unsigned long millisToNextUpdate))
+{
+	cb_onScheduleChange = callback;
+	for (int i = 0; i < _busCount; i++)
+		_buses[i]->onScheduleChange(callback);
+}
+
+/**
+ * @brief Time until update() has something to do on any bus
+ *
+ * @return unsigned long [milliseconds], 0 if update() must be called now, 0xFFFFFFFF if nothing is scheduled
+ */
+unsigned long NonBlockingDallasManager::millisToNextUpdate()
+{
+	unsigned long now = NBD_MILLIS();
+	unsigned long next = 0xFFFFFFFFUL;
+
+	for (int i = 0; i < _busCount; i++)
+	{
+		unsigned long busNext;
+		if (!_busStarted[i])
+		{
+			// The bus is due as soon as its start offset has passed
+			unsigned long elapsed = now - _beginMillis;
+			busNext = elapsed < _startOffset * i ? _startOffset * i - elapsed : 0;
+		}
+		else
+			busNext = _buses[i]->millisToNextUpdate();
+
+		if (busNext < next)
+			next = busNext;
+	}
+	return next;
+}
+
+/**
+ * @brief Queue the events of all the buses in one queue, with the indexes unique across the buses
+ */
+void NonBlockingDallasManager::attachEventQueue(NonBlockingDallasEventQueue *eventQueue)
+{
+	for (int i = 0; i < _busCount; i++)
+		_buses[i]->attachEventQueue(eventQueue);
+}
+
+/**
+ * @brief Invoke the callbacks of the queued events, see NonBlockingDallasBase::dispatch()
+ */
+uint8_t NonBlockingDallasManager::dispatch(uint8_t maxEvents, unsigned long budgetMicros)
+{
+	// The buses share the queue and the callbacks, any of them can deliver the events
+	if (_busCount == 0)
+		return 0;
+	return _buses[0]->dispatch(maxEvents, budgetMicros);
+}
+
+/**
+ * @brief Get the number of buses handled by the manager
+ */
+uint8_t NonBlockingDallasManager::getBusCount()
+{
+	return _busCount;
+}
+
+/**
+ * @brief Get a bus to use its own functions
+ *
+ * @return NULL if the bus does not exist
+ */
+NonBlockingDallasBase *NonBlockingDallasManager::getBus(uint8_t busIndex)
+{
+	if (busIndex >= _busCount)
+		return NULL;
+	return _buses[busIndex];
+}
+
+/**
+ * @brief Get the number of sensors found on all the buses
+ */
+uint8_t NonBlockingDallasManager::getSensorsCount()
+{
+	uint8_t count = 0;
+	for (int i = 0; i < _busCount; i++)
+		count += _buses[i]->getSensorsCount();
+	return count;
+}
+
+/**
+ * @brief Get the size of the index space, the sum of the capacities of the buses
+ */
+uint8_t NonBlockingDallasManager::getCapacity()
+{
+	uint8_t capacity = 0;
+	for (int i = 0; i < _busCount; i++)
+		capacity += _buses[i]->getCapacity();
+	return capacity;
+}
+
+/**
+ * @brief Translate a deviceIndex into the bus and the index on that bus
+ *
+ * Each bus owns a fixed range of indexes, as large as its capacity, in the order the buses were added.
+ *
+ * @return false if the index does not exist
+ */
+bool NonBlockingDallasManager::locate(uint8_t deviceIndex, uint8_t *busIndex, uint8_t *localIndex)
+{
+	for (int i = 0; i < _busCount; i++)
+	{
+		uint8_t capacity = _buses[i]->getCapacity();
+		if (deviceIndex < capacity)
+		{
+			*busIndex = i;
+			*localIndex = deviceIndex;
+			return deviceIndex < _buses[i]->getSensorsCount();
+		}
+		deviceIndex -= capacity;
+	}
+	return false;
+}
+
+bool NonBlockingDallasManager::indexExist(uint8_t deviceIndex)
+{
+	uint8_t busIndex, localIndex;
+	return this->locate(deviceIndex, &busIndex, &localIndex);
+}
+
+bool NonBlockingDallasManager::getDeviceAddress(uint8_t deviceIndex, DeviceAddress deviceAddress)
+{
+	uint8_t busIndex, localIndex;
+	if (!this->locate(deviceIndex, &busIndex, &localIndex))
+		return false;
+	return _buses[busIndex]->getDeviceAddress(localIndex, deviceAddress);
+}
+
+int32_t NonBlockingDallasManager::getTemperatureRAW(uint8_t deviceIndex)
+{
+	uint8_t busIndex, localIndex;
+	if (!this->locate(deviceIndex, &busIndex, &localIndex))
+		return DEVICE_DISCONNECTED_RAW;
+	return _buses[busIndex]->getTemperatureRAW(localIndex);
+}
+
+float NonBlockingDallasManager::getTemperatureC(uint8_t deviceIndex)
+{
+	uint8_t busIndex, localIndex;
+	if (!this->locate(deviceIndex, &busIndex, &localIndex))
+		return DEVICE_DISCONNECTED_C;
+	return _buses[busIndex]->getTemperatureC(localIndex);
+}
+
+float NonBlockingDallasManager::getTemperatureF(uint8_t deviceIndex)
+{
+	uint8_t busIndex, localIndex;
+	if (!this->locate(deviceIndex, &busIndex, &localIndex))
+		return DEVICE_DISCONNECTED_F;
+	return _buses[busIndex]->getTemperatureF(localIndex);
+}
+
+/**
+ * @brief Get device index from DeviceAddress, searching all the buses
+ *
+ * @return  x position index : 0 <= x < getCapacity()
+ * @return -1 address not found
+ * @return -2 buses have no sensor
+ */
+int8_t NonBlockingDallasManager::getIndex(const DeviceAddress deviceAddress)
+{
+	uint8_t offset = 0;
+	for (int i = 0; i < _busCount; i++)
+	{
+		int8_t localIndex = _buses[i]->getIndex(deviceAddress);
+		if (localIndex >= 0)
+			return offset + localIndex;
+		offset += _buses[i]->getCapacity();
+	}
+	return getSensorsCount() > 0 ? -1 : -2;
+}
+
+int32_t NonBlockingDallasManager::getTemperatureRAW(const DeviceAddress deviceAddress)
+{
+	int8_t deviceIndex = this->getIndex(deviceAddress);
+	if (deviceIndex < 0)
+		return DEVICE_DISCONNECTED_RAW;
+	return this->getTemperatureRAW((uint8_t)deviceIndex);
+}
+
+float NonBlockingDallasManager::getTemperatureC(const DeviceAddress deviceAddress)
+{
+	int8_t deviceIndex = this->getIndex(deviceAddress);
+	if (deviceIndex < 0)
+		return DEVICE_DISCONNECTED_C;
+	return this->getTemperatureC((uint8_t)deviceIndex);
+}
+
+float NonBlockingDallasManager::getTemperatureF(const DeviceAddress deviceAddress)
+{
+	int8_t deviceIndex = this->getIndex(deviceAddress);
+	if (deviceIndex < 0)
+		return DEVICE_DISCONNECTED_F;
+	return this->getTemperatureF((uint8_t)deviceIndex);
+}
@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasManager_h
+#define NonBlockingDallasManager_h
+
+#include <Arduino.h>
+#include "NonBlockingDallas.h"
+#define MANAGER_MAX_BUSES 4 // Maximum number of One wire buses handled by a manager
+
+class NonBlockingDallasManager
+{
+
+public:
+	NonBlockingDallasManager();
+	bool addBus(NonBlockingDallasBase *bus);
+	void begin(NonBlockingDallas::resolution res, unsigned long tempInterval);
+	void update();
+	void requestTemperature();
+	void onIntervalElapsed(void (*callback)(int deviceIndex, int32_t temperatureRAW));
+	void onTemperatureChange(void (*callback)(int deviceIndex, int32_t temperatureRAW));
+	void onDeviceDisconnected(void (*callback)(int deviceIndex));
+	void onScheduleChange(void (*callback)(unsigned long millisToNextUpdate));
+	unsigned long millisToNextUpdate();
+	void attachEventQueue(NonBlockingDallasEventQueue *eventQueue);
+	uint8_t dispatch(uint8_t maxEvents = 0, unsigned long budgetMicros = 0);
+
+	uint8_t getBusCount();
+	NonBlockingDallasBase *getBus(uint8_t busIndex);
+	uint8_t getSensorsCount();
+	uint8_t getCapacity();
+
+	/**
+	 * Functions below get by deviceIndex, unique across all the buses
+	 */
+
+	bool locate(uint8_t deviceIndex, uint8_t *busIndex, uint8_t *localIndex);
+	bool indexExist(uint8_t deviceIndex);
+	bool getDeviceAddress(uint8_t deviceIndex, DeviceAddress deviceAddress);
+	int32_t getTemperatureRAW(uint8_t deviceIndex);
+	float getTemperatureC(uint8_t deviceIndex);
+	float getTemperatureF(uint8_t deviceIndex);
+
+	/**
+	 * Functions below get by DeviceAddress
+	 */
+
+	int8_t getIndex(const DeviceAddress deviceAddress);
+	int32_t getTemperatureRAW(const DeviceAddress deviceAddress);
+	float getTemperatureC(const DeviceAddress deviceAddress);
+	float getTemperatureF(const DeviceAddress deviceAddress);
+
+private:
+	NonBlockingDallasBase *_buses[MANAGER_MAX_BUSES];
+	uint8_t _busCount;
+	uint8_t _nextBus;					   // First bus served by the next update(), rotates for fairness
+	bool _busStarted[MANAGER_MAX_BUSES];   // Bus has passed its start offset
+	unsigned long _beginMillis;			   // Time at begin()
+	unsigned long _startOffset;			   // Delay between the first conversion of two consecutive buses [milliseconds]
+
+	void (*cb_onDeviceDisconnected)(int deviceIndex);
+	void (*cb_onIntervalElapsed)(int deviceIndex, int32_t temperatureRAW);
+	void (*cb_onTemperatureChange)(int deviceIndex, int32_t temperatureRAW);
+	void (*cb_onScheduleChange)(unsigned long millisToNextUpdate);
+};
+
+#endif
@@ -0,0 +1,118 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasSnapshot.h"
+#include "NonBlockingDallas.h" // NBD_MEMORY_BARRIER()
+
+NonBlockingDallasSnapshot::NonBlockingDallasSnapshot(int32_t *temperatures, uint8_t *validMasks, uint8_t sensors)
+{
+	_temperatures = temperatures;
+	_validMasks = validMasks;
+	_sensors = sensors;
+	_counts[0] = 0;
+	_counts[1] = 0;
+	_started = 0;
+	_cycle = 0;
+}
+
+/**
+ * @brief Publish the temperatures of a cycle, invoked by NonBlockingDallas at the end of each readout
+ *
+ * Only one task may publish. The buffer written is the one of the previous cycle, the readers
+ * copy the other one
+ */
+void NonBlockingDallasSnapshot::publish(const int32_t *temperaturesRAW, const uint8_t *validMask, uint8_t count)
+{
+	uint32_t next = _cycle + 1;
+	uint8_t buffer = next & 1;
+	if (count > _sensors)
+		count = _sensors;
+
+	_started = next;
+	NBD_MEMORY_BARRIER();
+	int32_t *temperatures = _temperatures + buffer * _sensors;
+	uint8_t *mask = _validMasks + buffer * ((_sensors + 7) / 8);
+	for (uint8_t i = 0; i < count; i++)
+		temperatures[i] = temperaturesRAW[i];
+	for (uint8_t i = 0; i < (count + 7) / 8; i++)
+		mask[i] = validMask[i];
+	_counts[buffer] = count;
+	NBD_MEMORY_BARRIER();
+	_cycle = next;
+}
+
+/**
+ * @brief Copy the temperatures of the last cycle published
+ *
+ * Safe to call from another core or task while update() runs, all the values come from the same cycle.
+ * The copy is only overwritten when two cycles end while it runs, then it is attempted again,
+ * up to SNAPSHOT_READ_ATTEMPTS times. Only a reader preempted for whole cycles, by a task of
+ * higher priority, can run out of attempts.
+ *
+ * @param temperaturesRAW receives the temperature of sensor i at position i
+ * @param size number of elements of temperaturesRAW
+ * @param cycle if not NULL, receives the number of the cycle copied, 0 before the first one
+ * @param validMask if not NULL, receives the valid bits of the cycle, (size + 7) / 8 bytes
+ * @return number of temperatures copied, 0 if no consistent copy was made
+ */
+uint8_t NonBlockingDallasSnapshot::read(int32_t *temperaturesRAW, uint8_t size, uint32_t *cycle, uint8_t *validMask)
+{
+	for (uint8_t attempt = 0; attempt < SNAPSHOT_READ_ATTEMPTS; attempt++)
+	{
+		uint32_t copied = _cycle;
+		NBD_MEMORY_BARRIER();
+		uint8_t buffer = copied & 1;
+		uint8_t count = _counts[buffer] < size ? _counts[buffer] : size;
+		const int32_t *temperatures = _temperatures + buffer * _sensors;
+		const uint8_t *mask = _validMasks + buffer * ((_sensors + 7) / 8);
+		for (uint8_t i = 0; i < count; i++)
+			temperaturesRAW[i] = temperatures[i];
+		if (validMask)
+		{
+			for (uint8_t i = 0; i < (count + 7) / 8; i++)
+				validMask[i] = mask[i];
+		}
+		NBD_MEMORY_BARRIER();
+
+		// The publication following the copied one writes the other buffer, the next one this buffer
+		if (_started - copied < 2)
+		{
+			if (cycle)
+				*cycle = copied;
+			return count;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Number of the last cycle published, a change tells that read() has new values
+ */
+uint32_t NonBlockingDallasSnapshot::getCycle()
+{
+	return _cycle;
+}
+
+uint8_t NonBlockingDallasSnapshot::getSensors()
+{
+	return _sensors;
+}
@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasSnapshot_h
+#define NonBlockingDallasSnapshot_h
+
+#include <Arduino.h>
+
+// Copies attempted by read() before giving up, see read()
+#ifndef SNAPSHOT_READ_ATTEMPTS
+#define SNAPSHOT_READ_ATTEMPTS 4
+#endif
+
+/**
+ * Temperatures of the last cycle, published by update() and read from another core or task.
+ * Two buffers are used in turn: update() writes the one not being read and then flips the index,
+ * so it never waits for the readers. The storage is provided by NonBlockingDallasSnapshotN
+ */
+class NonBlockingDallasSnapshot
+{
+
+public:
+	void publish(const int32_t *temperaturesRAW, const uint8_t *validMask, uint8_t count);
+	uint8_t read(int32_t *temperaturesRAW, uint8_t size, uint32_t *cycle = NULL, uint8_t *validMask = NULL);
+	uint32_t getCycle();
+	uint8_t getSensors();
+
+protected:
+	NonBlockingDallasSnapshot(int32_t *temperatures, uint8_t *validMasks, uint8_t sensors);
+
+private:
+	int32_t *_temperatures;	  // Two buffers of _sensors temperatures
+	uint8_t *_validMasks;	  // Two buffers of (_sensors + 7) / 8 bytes
+	uint8_t _counts[2];		  // Sensors in each buffer
+	uint8_t _sensors;
+	volatile uint32_t _started; // Publications started, the one in progress writes buffer _started & 1
+	volatile uint32_t _cycle;	// Publications completed, the last one is in buffer _cycle & 1
+};
+
+/**
+ * Snapshot of up to SENSORS sensors, sensors beyond it are not published
+ */
+template <uint8_t SENSORS>
+class NonBlockingDallasSnapshotN : public NonBlockingDallasSnapshot
+{
+	static_assert(SENSORS > 0, "NonBlockingDallasSnapshotN needs at least one sensor");
+
+public:
+	NonBlockingDallasSnapshotN()
+		: NonBlockingDallasSnapshot(_temperatureSlots, _validMaskSlots, SENSORS)
+	{
+	}
+
+private:
+	int32_t _temperatureSlots[2 * SENSORS];
+	uint8_t _validMaskSlots[2 * ((SENSORS + 7) / 8)];
+};
+
+#endif
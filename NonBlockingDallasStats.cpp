@@ -0,0 +1,125 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasStats.h"
+
+NonBlockingDallasStats::NonBlockingDallasStats(sensorStats *sensors, uint8_t count)
+{
+	_sensors = sensors;
+	_count = count;
+	reset();
+}
+
+/**
+ * @brief Count an update() call, invoked by NonBlockingDallas
+ *
+ * @param onBus the call belongs to a conversion and readout cycle
+ */
+void NonBlockingDallasStats::recordUpdate(unsigned long updateMicros, bool onBus)
+{
+	_bus.updates++;
+	if (updateMicros > _bus.maxUpdateMicros)
+		_bus.maxUpdateMicros = updateMicros;
+	addToHistogram(_bus.updateMicros, updateMicros);
+	if (onBus)
+		_cycleBusMicros += updateMicros;
+}
+
+/**
+ * @brief Count the end of a readout, invoked by NonBlockingDallas after recordUpdate()
+ */
+void NonBlockingDallasStats::recordCycle(unsigned long conversionMillis)
+{
+	_bus.cycles++;
+	_bus.lastConversionMillis = conversionMillis;
+	addToHistogram(_bus.cycleBusMicros, _cycleBusMicros);
+	_cycleBusMicros = 0;
+}
+
+void NonBlockingDallasStats::recordRead(uint8_t deviceIndex, uint16_t conversionMillis)
+{
+	if (deviceIndex >= _count)
+		return;
+	_sensors[deviceIndex].reads++;
+	_sensors[deviceIndex].conversionMillis = conversionMillis;
+}
+
+/**
+ * @param answered the sensor answered with a corrupted scratchpad, otherwise it did not answer
+ */
+void NonBlockingDallasStats::recordFailure(uint8_t deviceIndex, bool answered)
+{
+	if (deviceIndex >= _count)
+		return;
+	if (answered)
+		_sensors[deviceIndex].crcErrors++;
+	else
+		_sensors[deviceIndex].disconnects++;
+}
+
+/**
+ * @brief Copy the counters of the bus
+ */
+void NonBlockingDallasStats::getBusStats(busStats &stats)
+{
+	stats = _bus;
+}
+
+/**
+ * @brief Copy the counters of a sensor
+ *
+ * @return false if the index is beyond the sensors of the storage
+ */
+bool NonBlockingDallasStats::getSensorStats(uint8_t deviceIndex, sensorStats &stats)
+{
+	if (deviceIndex >= _count)
+		return false;
+	stats = _sensors[deviceIndex];
+	return true;
+}
+
+uint8_t NonBlockingDallasStats::getSensors()
+{
+	return _count;
+}
+
+/**
+ * @brief Clear the counters of the bus and of all the sensors
+ */
+void NonBlockingDallasStats::reset()
+{
+	memset(&_bus, 0, sizeof(_bus));
+	memset(_sensors, 0, sizeof(sensorStats) * _count);
+	_cycleBusMicros = 0;
+}
+
+void NonBlockingDallasStats::addToHistogram(uint32_t *histogram, unsigned long micros)
+{
+	uint8_t bucket = 0;
+	micros >>= 3;
+	while (micros > 1 && bucket < STATS_HISTOGRAM_BUCKETS - 1)
+	{
+		micros >>= 1;
+		bucket++;
+	}
+	histogram[bucket]++;
+}
@@ -0,0 +1,100 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasStats_h
+#define NonBlockingDallasStats_h
+
+#include <Arduino.h>
+
+// Buckets of the duration histograms: bucket 0 counts durations under 16 us, bucket k from 2^(k+3) to 2^(k+4) us,
+// the last one everything longer
+#ifndef STATS_HISTOGRAM_BUCKETS
+#define STATS_HISTOGRAM_BUCKETS 16
+#endif
+
+/**
+ * Counters of a bus and of its sensors. Once attached to NonBlockingDallas they are updated
+ * by update() without printing anything. The storage is provided by NonBlockingDallasStatsN
+ */
+class NonBlockingDallasStats
+{
+
+public:
+	struct sensorStats
+	{
+		uint32_t reads;			  // Valid readings
+		uint32_t disconnects;	  // Readings failed with no answer from the sensor
+		uint32_t crcErrors;		  // Readings failed with a corrupted scratchpad
+		uint16_t conversionMillis; // Measured time from the conversion request to the last reading [milliseconds]
+	};
+
+	struct busStats
+	{
+		uint32_t updates;						   // update() calls
+		uint32_t cycles;						   // Completed conversion and readout cycles
+		unsigned long maxUpdateMicros;			   // Longest update() call [microseconds]
+		unsigned long lastConversionMillis;		   // Measured time of the last conversion [milliseconds]
+		uint32_t updateMicros[STATS_HISTOGRAM_BUCKETS]; // Histogram of the update() duration
+		uint32_t cycleBusMicros[STATS_HISTOGRAM_BUCKETS]; // Histogram of the time spent on the bus by each cycle
+	};
+
+	void recordUpdate(unsigned long updateMicros, bool onBus);
+	void recordCycle(unsigned long conversionMillis);
+	void recordRead(uint8_t deviceIndex, uint16_t conversionMillis);
+	void recordFailure(uint8_t deviceIndex, bool answered);
+
+	void getBusStats(busStats &stats);
+	bool getSensorStats(uint8_t deviceIndex, sensorStats &stats);
+	uint8_t getSensors();
+	void reset();
+
+protected:
+	NonBlockingDallasStats(sensorStats *sensors, uint8_t count);
+
+private:
+	sensorStats *_sensors;
+	uint8_t _count;
+	busStats _bus;
+	unsigned long _cycleBusMicros; // Time spent on the bus by the cycle in progress [microseconds]
+
+	static void addToHistogram(uint32_t *histogram, unsigned long micros);
+};
+
+/**
+ * Counters of a bus with up to SENSORS sensors, sensors beyond it are not counted
+ */
+template <uint8_t SENSORS>
+class NonBlockingDallasStatsN : public NonBlockingDallasStats
+{
+	static_assert(SENSORS > 0, "NonBlockingDallasStatsN needs at least one sensor");
+
+public:
+	NonBlockingDallasStatsN()
+		: NonBlockingDallasStats(_sensorSlots, SENSORS)
+	{
+	}
+
+private:
+	sensorStats _sensorSlots[SENSORS];
+};
+
+#endif
@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasThresholds.h"
+
+NonBlockingDallasThresholds::NonBlockingDallasThresholds(sensorThresholds *thresholds, uint8_t sensors)
+{
+	_thresholds = thresholds;
+	_sensors = sensors;
+	for (uint8_t i = 0; i < _sensors; i++)
+		setThresholds(i, INT16_MIN, INT16_MAX);
+}
+
+/**
+ * @param lowRAW lower threshold, INT16_MIN for none
+ * @param highRAW upper threshold, INT16_MAX for none
+ * @return false if the sensor is beyond the thresholds
+ */
+bool NonBlockingDallasThresholds::setThresholds(uint8_t deviceIndex, int16_t lowRAW, int16_t highRAW)
+{
+	if (deviceIndex >= _sensors)
+		return false;
+	_thresholds[deviceIndex].low = lowRAW;
+	_thresholds[deviceIndex].high = highRAW;
+	return true;
+}
+
+/**
+ * @brief Thresholds of a sensor, INT16_MIN and INT16_MAX when not set or beyond the thresholds
+ */
+void NonBlockingDallasThresholds::getThresholds(uint8_t deviceIndex, int16_t &lowRAW, int16_t &highRAW)
+{
+	lowRAW = deviceIndex < _sensors ? _thresholds[deviceIndex].low : INT16_MIN;
+	highRAW = deviceIndex < _sensors ? _thresholds[deviceIndex].high : INT16_MAX;
+}
+
+uint8_t NonBlockingDallasThresholds::getSensors()
+{
+	return _sensors;
+}
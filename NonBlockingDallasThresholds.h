@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasThresholds_h
+#define NonBlockingDallasThresholds_h
+
+#include <Arduino.h>
+
+/**
+ * Low and high threshold of each sensor, followed by the adaptive interval, the adaptive resolution
+ * and the alarm mode. Once attached to NonBlockingDallas it is set by setThresholds().
+ * The storage is provided by NonBlockingDallasThresholdsN
+ */
+class NonBlockingDallasThresholds
+{
+
+public:
+	bool setThresholds(uint8_t deviceIndex, int16_t lowRAW, int16_t highRAW);
+	void getThresholds(uint8_t deviceIndex, int16_t &lowRAW, int16_t &highRAW);
+	uint8_t getSensors();
+
+protected:
+	struct sensorThresholds
+	{
+		int16_t low;  // INT16_MIN when not set [RAW]
+		int16_t high; // INT16_MAX when not set [RAW]
+	};
+
+	NonBlockingDallasThresholds(sensorThresholds *thresholds, uint8_t sensors);
+
+private:
+	sensorThresholds *_thresholds;
+	uint8_t _sensors;
+};
+
+/**
+ * Thresholds of up to SENSORS sensors, sensors beyond it have none
+ */
+template <uint8_t SENSORS>
+class NonBlockingDallasThresholdsN : public NonBlockingDallasThresholds
+{
+	static_assert(SENSORS > 0, "NonBlockingDallasThresholdsN needs at least one sensor");
+
+public:
+	NonBlockingDallasThresholdsN()
+		: NonBlockingDallasThresholds(_thresholdSlots, SENSORS)
+	{
+	}
+
+private:
+	sensorThresholds _thresholdSlots[SENSORS];
+};
+
+#endif
@@ -0,0 +1,113 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasTimings.h"
+
+NonBlockingDallasTimings::NonBlockingDallasTimings(sampleTiming *timings, uint8_t sensors)
+{
+	_timings = timings;
+	_sensors = sensors;
+	startCycle(0);
+}
+
+/**
+ * @brief Forget the times of the previous cycle, invoked by NonBlockingDallas at the conversion request
+ */
+void NonBlockingDallasTimings::startCycle(unsigned long startMillis)
+{
+	_startMillis = startMillis;
+	for (uint8_t i = 0; i < _sensors; i++)
+		clear(i);
+}
+
+void NonBlockingDallasTimings::recordConversion(uint8_t deviceIndex, unsigned long timeMillis)
+{
+	if (deviceIndex < _sensors)
+		_timings[deviceIndex].conversionDelta = delta(timeMillis);
+}
+
+void NonBlockingDallasTimings::recordRead(uint8_t deviceIndex, unsigned long timeMillis)
+{
+	if (deviceIndex < _sensors)
+		_timings[deviceIndex].readDelta = delta(timeMillis);
+}
+
+/**
+ * @brief Mark a sensor as not converted and not read in the current cycle
+ */
+void NonBlockingDallasTimings::clear(uint8_t deviceIndex)
+{
+	if (deviceIndex >= _sensors)
+		return;
+	_timings[deviceIndex].conversionDelta = 0xFFFF;
+	_timings[deviceIndex].readDelta = 0xFFFF;
+}
+
+/**
+ * @brief NBD_MILLIS() at the start of the last cycle
+ */
+unsigned long NonBlockingDallasTimings::getCycleStart()
+{
+	return _startMillis;
+}
+
+/**
+ * @return conversion request since the start of the cycle [milliseconds], 0xFFFF if not converted
+ */
+uint16_t NonBlockingDallasTimings::getConversionDelta(uint8_t deviceIndex)
+{
+	return deviceIndex < _sensors ? _timings[deviceIndex].conversionDelta : 0xFFFF;
+}
+
+/**
+ * @return readout since the start of the cycle [milliseconds], 0xFFFF if not read
+ */
+uint16_t NonBlockingDallasTimings::getReadDelta(uint8_t deviceIndex)
+{
+	return deviceIndex < _sensors ? _timings[deviceIndex].readDelta : 0xFFFF;
+}
+
+/**
+ * @brief Time of the conversion request and of the readout of a sensor in the last cycle [milliseconds]
+ *
+ * @return false if the sensor was not read in the last cycle
+ */
+bool NonBlockingDallasTimings::getSampleTimes(uint8_t deviceIndex, unsigned long &conversionMillis, unsigned long &readMillis)
+{
+	if (getReadDelta(deviceIndex) == 0xFFFF)
+		return false;
+	conversionMillis = _startMillis + _timings[deviceIndex].conversionDelta;
+	readMillis = _startMillis + _timings[deviceIndex].readDelta;
+	return true;
+}
+
+uint8_t NonBlockingDallasTimings::getSensors()
+{
+	return _sensors;
+}
+
+// 0xFFFF marks a sensor not timed, longer deltas are clamped below it
+uint16_t NonBlockingDallasTimings::delta(unsigned long timeMillis)
+{
+	unsigned long delta = timeMillis - _startMillis;
+	return delta < 0xFFFE ? delta : 0xFFFE;
+}
@@ -0,0 +1,83 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasTimings_h
+#define NonBlockingDallasTimings_h
+
+#include <Arduino.h>
+
+/**
+ * Time of the conversion request and of the readout of each sensor in the last cycle, as 16 bit
+ * deltas from the start of the cycle. Once attached to NonBlockingDallas they are filled by update()
+ * and written by exportCycle(). The storage is provided by NonBlockingDallasTimingsN
+ */
+class NonBlockingDallasTimings
+{
+
+public:
+	void startCycle(unsigned long startMillis);
+	void recordConversion(uint8_t deviceIndex, unsigned long timeMillis);
+	void recordRead(uint8_t deviceIndex, unsigned long timeMillis);
+	void clear(uint8_t deviceIndex);
+
+	unsigned long getCycleStart();
+	uint16_t getConversionDelta(uint8_t deviceIndex);
+	uint16_t getReadDelta(uint8_t deviceIndex);
+	bool getSampleTimes(uint8_t deviceIndex, unsigned long &conversionMillis, unsigned long &readMillis);
+	uint8_t getSensors();
+
+protected:
+	struct sampleTiming
+	{
+		uint16_t conversionDelta; // Conversion request since the start of the cycle, 0xFFFF if not converted [milliseconds]
+		uint16_t readDelta;		  // Readout since the start of the cycle, 0xFFFF if not read [milliseconds]
+	};
+
+	NonBlockingDallasTimings(sampleTiming *timings, uint8_t sensors);
+
+private:
+	sampleTiming *_timings;
+	uint8_t _sensors;
+	unsigned long _startMillis; // Conversion request of the first sensor of the cycle
+
+	uint16_t delta(unsigned long timeMillis);
+};
+
+/**
+ * Timings of up to SENSORS sensors, sensors beyond it are not timed
+ */
+template <uint8_t SENSORS>
+class NonBlockingDallasTimingsN : public NonBlockingDallasTimings
+{
+	static_assert(SENSORS > 0, "NonBlockingDallasTimingsN needs at least one sensor");
+
+public:
+	NonBlockingDallasTimingsN()
+		: NonBlockingDallasTimings(_timingSlots, SENSORS)
+	{
+	}
+
+private:
+	sampleTiming _timingSlots[SENSORS];
+};
+
+#endif
@@ -0,0 +1,553 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonBlockingDallasTrace.h"
+
+NonBlockingDallasTrace::NonBlockingDallasTrace(uint8_t *buffer, size_t size)
+{
+	_buffer = buffer;
+	_size = size;
+	_length = 0;
+	_replayData = NULL;
+	_replayLength = 0;
+	_cursor = 0;
+	_cursorMicros = 0;
+	_mode = idle;
+	_overflowed = false;
+	_parasite = false;
+	_records = 0;
+	_busMicros = 0;
+	_mismatches = 0;
+	_lastMicros = 0;
+	_conversionStartMicros = 0;
+	_conversionMicros = 0;
+	_bitCount = 0;
+	_bitPosition = 0;
+	_bitStartMicros = 0;
+	_bitBusMicros = 0;
+	_pollCount = 0;
+	_pollStartMicros = 0;
+	_pollBusMicros = 0;
+}
+
+/**
+ * @brief Discard the recorded trace and record the next bus operations
+ */
+void NonBlockingDallasTrace::startRecording()
+{
+	_buffer[0] = 'N';
+	_buffer[1] = 'T';
+	_buffer[2] = TRACE_VERSION;
+	_length = TRACE_HEADER_SIZE;
+	_overflowed = false;
+	_records = 0;
+	_busMicros = 0;
+	_mismatches = 0;
+	_lastMicros = 0;
+	_bitCount = 0;
+	_pollCount = 0;
+	_mode = recording;
+}
+
+/**
+ * @brief Replay the recorded trace
+ *
+ * @return false if nothing has been recorded
+ */
+bool NonBlockingDallasTrace::startReplay()
+{
+	flushPending();
+	return startReplay(_buffer, _length);
+}
+
+/**
+ * @brief Replay a trace in place of the bus
+ *
+ * The library operations are matched in order with the recorded ones. An operation not found within
+ * TRACE_LOOKAHEAD records is counted by getMismatches() and answered as a missing sensor, and the
+ * conversion ends after the recorded time, measured with NBD_MICROS()
+ *
+ * @param trace trace returned by getData(), the buffer must be kept until the replay ends
+ * @return false if the trace is not valid
+ */
+bool NonBlockingDallasTrace::startReplay(const uint8_t *trace, size_t length)
+{
+	_mode = idle;
+	if (length < TRACE_HEADER_SIZE || trace[0] != 'N' || trace[1] != 'T' || trace[2] != TRACE_VERSION)
+		return false;
+
+	_replayData = trace;
+	_replayLength = length;
+	_cursor = TRACE_HEADER_SIZE;
+	_cursorMicros = 0;
+	_records = 0;
+	_busMicros = 0;
+	_mismatches = 0;
+	_parasite = false;
+	_conversionStartMicros = 0;
+	_conversionMicros = 0;
+	_bitCount = 0;
+	_bitPosition = 0;
+	_mode = replaying;
+	return true;
+}
+
+/**
+ * @brief Stop recording or replaying, the bus is used again
+ */
+void NonBlockingDallasTrace::stop()
+{
+	flushPending();
+	_mode = idle;
+}
+
+NonBlockingDallasTrace::traceMode NonBlockingDallasTrace::getMode()
+{
+	return _mode;
+}
+
+/**
+ * @brief Get the recorded trace, getLength() bytes
+ */
+const uint8_t *NonBlockingDallasTrace::getData()
+{
+	flushPending();
+	return _buffer;
+}
+
+size_t NonBlockingDallasTrace::getLength()
+{
+	flushPending();
+	return _length;
+}
+
+/**
+ * @brief The buffer was full, the following operations have not been recorded
+ */
+bool NonBlockingDallasTrace::isOverflowed()
+{
+	return _overflowed;
+}
+
+/**
+ * @brief Get the number of records written or replayed
+ */
+uint32_t NonBlockingDallasTrace::getRecordCount()
+{
+	return _records;
+}
+
+/**
+ * @brief Get the bus time of the operations recorded, or the recorded bus time of the operations replayed [microseconds]
+ */
+unsigned long NonBlockingDallasTrace::getBusMicros()
+{
+	return _busMicros;
+}
+
+/**
+ * @brief Get the number of operations of the library missing in the replayed trace
+ */
+uint16_t NonBlockingDallasTrace::getMismatches()
+{
+	return _mismatches;
+}
+
+bool NonBlockingDallasTrace::isReplayFinished()
+{
+	return _mode != replaying || _cursor >= _replayLength;
+}
+
+/**
+ * @brief Get the recorded start of the next operation replayed, to move a simulated clock forward
+ *
+ * @return false if the replay is finished
+ */
+bool NonBlockingDallasTrace::nextRecordMicros(unsigned long &timeMicros)
+{
+	if (_mode != replaying)
+		return false;
+
+	size_t offset = _cursor;
+	record r;
+	timeMicros = _cursorMicros;
+	if (!readRecord(offset, timeMicros, r))
+		return false;
+	timeMicros = r.startMicros;
+	return true;
+}
+
+/**
+ * @brief Decode a record of the trace replayed, or of the recorded one when not replaying
+ *
+ * @param offset 0 for the first record, then moved past the record decoded
+ * @param timeMicros start of the previous record, 0 for the first one
+ * @return false at the end of the trace
+ */
+bool NonBlockingDallasTrace::readRecord(size_t &offset, unsigned long &timeMicros, record &r)
+{
+	const uint8_t *data = _mode == replaying ? _replayData : _buffer;
+	size_t length = _mode == replaying ? _replayLength : _length;
+	uint32_t value;
+
+	if (offset < TRACE_HEADER_SIZE)
+	{
+		offset = TRACE_HEADER_SIZE;
+		timeMicros = 0;
+	}
+	if (offset >= length)
+		return false;
+
+	size_t next = offset;
+	r.op = data[next] & 0x7F;
+	r.result = data[next++] & 0x80;
+	if (r.op < opEnumerate || r.op > opSearchBits)
+		return false;
+
+	if (!readVarint(next, value))
+		return false;
+	r.startMicros = timeMicros + value;
+	if (!readVarint(next, value))
+		return false;
+	r.durationMicros = value;
+
+	r.deviceIndex = 0xFF;
+	if (hasIndex(r.op))
+	{
+		if (next >= length)
+			return false;
+		r.deviceIndex = data[next++];
+	}
+
+	r.value = 0;
+	if (hasValue(r.op))
+	{
+		if (!readVarint(next, value))
+			return false;
+		r.value = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+	}
+
+	r.dataLength = dataLength(r.op, r.result, r.value);
+	if (next + r.dataLength > length)
+		return false;
+	for (uint8_t i = 0; i < r.dataLength; i++)
+		r.data[i] = data[next++];
+
+	offset = next;
+	timeMicros = r.startMicros;
+	return true;
+}
+
+/**
+ * @brief Record an operation, invoked by NonBlockingDallas
+ */
+void NonBlockingDallasTrace::add(const record &r)
+{
+	if (_mode != recording)
+		return;
+	if (r.op != opSearchBits && !(r.op == opPoll && !r.result))
+		flushPending();
+
+	uint8_t encoded[3 + 5 * 3 + TRACE_MAX_DATA];
+	uint8_t length = 0;
+	encoded[length++] = r.op | (r.result ? 0x80 : 0);
+	writeVarint(encoded, length, r.startMicros - _lastMicros);
+	writeVarint(encoded, length, r.durationMicros);
+	if (hasIndex(r.op))
+		encoded[length++] = r.deviceIndex;
+	if (hasValue(r.op))
+		writeVarint(encoded, length, ((uint32_t)r.value << 1) ^ (uint32_t)(r.value >> 31));
+	for (uint8_t i = 0; i < dataLength(r.op, r.result, r.value); i++)
+		encoded[length++] = r.data[i];
+
+	// Records are never truncated, the trace stays readable up to the overflow
+	if (_overflowed || _length + length > _size)
+	{
+		_overflowed = true;
+		return;
+	}
+	for (uint8_t i = 0; i < length; i++)
+		_buffer[_length++] = encoded[i];
+	_lastMicros = r.startMicros;
+	_records++;
+	_busMicros += r.durationMicros;
+}
+
+/**
+ * @brief Record the id and complement bits read by the discovery, invoked by NonBlockingDallas
+ */
+void NonBlockingDallasTrace::addSearchBits(uint8_t pair, unsigned long startMicros, unsigned long durationMicros)
+{
+	if (_mode != recording)
+		return;
+
+	if (_bitCount == 0)
+	{
+		_bitStartMicros = startMicros;
+		_bitBusMicros = 0;
+		for (uint8_t i = 0; i < TRACE_MAX_DATA; i++)
+			_bits[i] = 0;
+	}
+	_bits[_bitCount >> 2] |= (pair & 3) << ((_bitCount & 3) * 2);
+	_bitCount++;
+	_bitBusMicros += durationMicros;
+	if (_bitCount == TRACE_MAX_DATA * 4)
+		flushPending();
+}
+
+/**
+ * @brief Record a poll of the conversion, invoked by NonBlockingDallas
+ */
+void NonBlockingDallasTrace::addPoll(bool complete, unsigned long startMicros, unsigned long durationMicros)
+{
+	if (_mode != recording)
+		return;
+
+	if (complete)
+	{
+		// Recorded alone, its start is the end of the conversion
+		record r;
+		r.op = opPoll;
+		r.result = true;
+		r.deviceIndex = 0xFF;
+		r.startMicros = startMicros;
+		r.durationMicros = durationMicros;
+		r.value = 1;
+		r.dataLength = 0;
+		add(r);
+		return;
+	}
+
+	if (_pollCount == 0)
+	{
+		_pollStartMicros = startMicros;
+		_pollBusMicros = 0;
+	}
+	_pollCount++;
+	_pollBusMicros += durationMicros;
+	if (_pollCount == 0xFFFF)
+		flushPending();
+}
+
+/**
+ * @brief Take the next recorded operation asked by the library, invoked by NonBlockingDallas
+ *
+ * Records of other operations are skipped, up to TRACE_LOOKAHEAD. A full read replays a fast read too,
+ * a fast read replaying a full one is answered as no presence so that the library falls back to the full read
+ *
+ * @return false if the operation is not in the trace
+ */
+bool NonBlockingDallasTrace::find(uint8_t op, uint8_t deviceIndex, record &r, unsigned long nowMicros)
+{
+	if (_mode != replaying)
+		return false;
+
+	// A conversion lasts as recorded from the time the library requests it
+	if (op == opRequestAll || op == opRequestOne)
+		_conversionStartMicros = nowMicros;
+	if (op == opSearchReset)
+		_bitCount = _bitPosition = 0;
+
+	size_t offset = _cursor;
+	unsigned long time = _cursorMicros;
+	for (uint8_t n = 0; n < TRACE_LOOKAHEAD && readRecord(offset, time, r); n++)
+	{
+		bool sameDevice = !hasIndex(op) || r.deviceIndex == deviceIndex;
+		if (op == opReadFast && r.op == opRead && sameDevice)
+			return false;
+		if ((r.op != op && !(op == opRead && r.op == opReadFast)) || !sameDevice)
+			continue;
+
+		_cursor = offset;
+		_cursorMicros = time;
+		_records++;
+		_busMicros += r.durationMicros;
+		if (op == opEnumerate || op == opPowerSupply)
+			_parasite = r.result;
+
+		if (op == opRequestAll || op == opRequestOne)
+		{
+			// The conversion ended at the first poll answered, or at the first readout without polling
+			record end;
+			_conversionMicros = 0;
+			for (uint8_t i = 0; i < 4 * TRACE_LOOKAHEAD && readRecord(offset, time, end); i++)
+			{
+				if (end.op == opRequestAll || end.op == opRequestOne)
+					continue;
+				if ((end.op == opPoll && end.result) || end.op == opRead || end.op == opReadFast || end.op == opAlarmSearch)
+				{
+					_conversionMicros = end.startMicros - r.startMicros;
+					break;
+				}
+			}
+		}
+		return true;
+	}
+
+	_mismatches++;
+	return false;
+}
+
+/**
+ * @brief Replay a poll of the conversion, invoked by NonBlockingDallas
+ *
+ * @return true once the recorded conversion time has elapsed since the request
+ */
+bool NonBlockingDallasTrace::replayConversion(unsigned long nowMicros)
+{
+	bool complete = nowMicros - _conversionStartMicros >= _conversionMicros;
+	size_t offset = _cursor;
+	unsigned long time = _cursorMicros;
+	record r;
+
+	// The recorded polls are taken in order, a library polling more often than the trace keeps the last one
+	while (readRecord(offset, time, r) && r.op == opPoll)
+	{
+		if (!complete && r.result)
+			break;
+		_cursor = offset;
+		_cursorMicros = time;
+		_records++;
+		_busMicros += r.durationMicros;
+		if (!complete || r.result)
+			break;
+	}
+	return complete;
+}
+
+/**
+ * @brief Replay the id and complement bits of the discovery, invoked by NonBlockingDallas
+ *
+ * @return the pair of bits, 3 (nobody answering) at the end of the trace
+ */
+uint8_t NonBlockingDallasTrace::replaySearchBits(unsigned long nowMicros)
+{
+	if (_bitPosition >= _bitCount)
+	{
+		record r;
+		_bitCount = _bitPosition = 0;
+		if (!find(opSearchBits, 0xFF, r, nowMicros))
+			return 3;
+		for (uint8_t i = 0; i < r.dataLength; i++)
+			_bits[i] = r.data[i];
+		_bitCount = r.value;
+		if (_bitCount == 0)
+			return 3;
+	}
+
+	uint8_t pair = (_bits[_bitPosition >> 2] >> ((_bitPosition & 3) * 2)) & 3;
+	_bitPosition++;
+	return pair;
+}
+
+/**
+ * @brief Get the power mode of the replayed bus
+ */
+bool NonBlockingDallasTrace::isParasite()
+{
+	return _parasite;
+}
+
+void NonBlockingDallasTrace::flushPending()
+{
+	if (_mode != recording)
+		return;
+
+	record r;
+	r.result = false;
+	r.deviceIndex = 0xFF;
+	if (_bitCount > 0)
+	{
+		r.op = opSearchBits;
+		r.startMicros = _bitStartMicros;
+		r.durationMicros = _bitBusMicros;
+		r.value = _bitCount;
+		r.dataLength = (_bitCount + 3) / 4;
+		for (uint8_t i = 0; i < r.dataLength; i++)
+			r.data[i] = _bits[i];
+		_bitCount = 0;
+		add(r);
+	}
+	if (_pollCount > 0)
+	{
+		r.op = opPoll;
+		r.result = false;
+		r.startMicros = _pollStartMicros;
+		r.durationMicros = _pollBusMicros;
+		r.value = _pollCount;
+		r.dataLength = 0;
+		_pollCount = 0;
+		add(r);
+	}
+}
+
+// 7 bits per byte, the high bit is set on all the bytes but the last
+void NonBlockingDallasTrace::writeVarint(uint8_t *out, uint8_t &length, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out[length++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	out[length++] = value;
+}
+
+bool NonBlockingDallasTrace::readVarint(size_t &offset, uint32_t &value)
+{
+	const uint8_t *data = _mode == replaying ? _replayData : _buffer;
+	size_t length = _mode == replaying ? _replayLength : _length;
+
+	value = 0;
+	for (uint8_t shift = 0; shift < 35; shift += 7)
+	{
+		if (offset >= length)
+			return false;
+		uint8_t b = data[offset++];
+		value |= (uint32_t)(b & 0x7F) << shift;
+		if (!(b & 0x80))
+			return true;
+	}
+	return false;
+}
+
+bool NonBlockingDallasTrace::hasIndex(uint8_t op)
+{
+	return op == opAddress || op == opResolution || op == opAlarms || op == opRequestOne ||
+		   op == opRead || op == opReadFast || op == opScratchPad;
+}
+
+bool NonBlockingDallasTrace::hasValue(uint8_t op)
+{
+	return op == opEnumerate || op == opResolution || op == opAlarms || op == opPoll ||
+		   op == opRead || op == opReadFast || op == opSearchBits;
+}
+
+uint8_t NonBlockingDallasTrace::dataLength(uint8_t op, bool result, int32_t value)
+{
+	if ((op == opAddress || op == opAlarmSearch) && result)
+		return 8;
+	if (op == opScratchPad && result)
+		return 9;
+	if (op == opSearchBits)
+		return value > 0 && value <= TRACE_MAX_DATA * 4 ? (value + 3) / 4 : 0;
+	return 0;
+}
@@ -0,0 +1,162 @@
+// MIT License
+//
+// Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef NonBlockingDallasTrace_h
+#define NonBlockingDallasTrace_h
+
+#include <Arduino.h>
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 3	 // 'N', 'T', TRACE_VERSION
+#define TRACE_LOOKAHEAD 8	 // Records skipped by the replay to find the operation asked by the library
+#define TRACE_MAX_DATA 16	 // Largest payload of a record, 64 search bit pairs
+
+/**
+ * Record of the bus operations issued by NonBlockingDallas, and replay of them in place of the bus.
+ * Each record holds the operation, its start time, its duration and its result; times are delta encoded
+ * varints so a readout of a sensor takes about 6 bytes. A trace captured on a field unit can be replayed
+ * on a host build, with a simulated time source, faster than real time.
+ * The recording storage is provided by NonBlockingDallasTraceN
+ */
+class NonBlockingDallasTrace
+{
+
+public:
+	enum operation
+	{
+		opEnumerate = 1, // DallasTemperature::begin(), value: sensors count, result: parasite power
+		opAddress,		 // getAddress(), data: address
+		opPowerSupply,	 // readPowerSupply(), result: parasite power
+		opResolution,	 // setResolution(), index 0xFF for all the sensors, value: bits
+		opAlarms,		 // setHighAlarmTemp() and setLowAlarmTemp(), value: TH << 8 | TL
+		opRequestAll,	 // Broadcast conversion
+		opRequestOne,	 // Addressed conversion
+		opPoll,			 // isConversionComplete(), value: polls, consecutive polls not answered are merged
+		opRead,			 // getTemp(), value: temperature RAW
+		opReadFast,		 // Two bytes of the scratchpad, value: temperature register, result: presence
+		opScratchPad,	 // readScratchPad(), data: scratchpad
+		opAlarmSearch,	 // alarmSearch(), data: address
+		opSearchReset,	 // Start of a discovery pass, result: presence
+		opSearchBits	 // Discovery bits, value: pairs count, data: id and complement bits, two per pair
+	};
+
+	enum traceMode
+	{
+		idle = 0,
+		recording,
+		replaying
+	};
+
+	struct record
+	{
+		uint8_t op;				  // operation
+		bool result;
+		uint8_t deviceIndex;	  // 0xFF if the operation is not addressed
+		unsigned long startMicros;
+		unsigned long durationMicros;
+		int32_t value;
+		uint8_t dataLength;
+		uint8_t data[TRACE_MAX_DATA];
+	};
+
+	void startRecording();
+	bool startReplay();
+	bool startReplay(const uint8_t *trace, size_t length);
+	void stop();
+
+	traceMode getMode();
+	const uint8_t *getData();
+	size_t getLength();
+	bool isOverflowed();
+	uint32_t getRecordCount();
+	unsigned long getBusMicros();
+	uint16_t getMismatches();
+	bool isReplayFinished();
+	bool nextRecordMicros(unsigned long &timeMicros);
+	bool readRecord(size_t &offset, unsigned long &timeMicros, record &r);
+
+	// Invoked by NonBlockingDallas
+	void add(const record &r);
+	void addSearchBits(uint8_t pair, unsigned long startMicros, unsigned long durationMicros);
+	void addPoll(bool complete, unsigned long startMicros, unsigned long durationMicros);
+	bool find(uint8_t op, uint8_t deviceIndex, record &r, unsigned long nowMicros);
+	bool replayConversion(unsigned long nowMicros);
+	uint8_t replaySearchBits(unsigned long nowMicros);
+	bool isParasite();
+
+protected:
+	NonBlockingDallasTrace(uint8_t *buffer, size_t size);
+
+private:
+	uint8_t *_buffer;
+	size_t _size;
+	size_t _length;			   // Bytes recorded
+	const uint8_t *_replayData; // Trace replayed, the recording buffer or an external one
+	size_t _replayLength;
+	size_t _cursor;				// Offset of the next record replayed
+	unsigned long _cursorMicros; // Start of the record before the cursor
+	traceMode _mode;
+	bool _overflowed;
+	bool _parasite;				// Replayed power mode
+	uint32_t _records;
+	unsigned long _busMicros;	// Duration of the operations recorded or replayed
+	uint16_t _mismatches;		// Operations of the library not found in the replayed trace
+	unsigned long _lastMicros;	// Start of the last record written
+	unsigned long _conversionStartMicros; // Replay time of the last conversion request
+	unsigned long _conversionMicros; // Recorded duration of the last conversion requested
+
+	// Discovery bits and polls not answered are grouped in one record until another operation is recorded
+	uint8_t _bits[TRACE_MAX_DATA];
+	uint8_t _bitCount;
+	uint8_t _bitPosition;
+	unsigned long _bitStartMicros;
+	unsigned long _bitBusMicros;
+	uint16_t _pollCount;
+	unsigned long _pollStartMicros;
+	unsigned long _pollBusMicros;
+
+	void flushPending();
+	void writeVarint(uint8_t *out, uint8_t &length, uint32_t value);
+	bool readVarint(size_t &offset, uint32_t &value);
+	static bool hasIndex(uint8_t op);
+	static bool hasValue(uint8_t op);
+	static uint8_t dataLength(uint8_t op, bool result, int32_t value);
+};
+
+/**
+ * Trace recording up to SIZE bytes
+ */
+template <size_t SIZE>
+class NonBlockingDallasTraceN : public NonBlockingDallasTrace
+{
+	static_assert(SIZE > TRACE_HEADER_SIZE, "NonBlockingDallasTraceN needs room for the records");
+
+public:
+	NonBlockingDallasTraceN()
+		: NonBlockingDallasTrace(_traceSlots, SIZE)
+	{
+	}
+
+private:
+	uint8_t _traceSlots[SIZE];
+};
+
+#endif
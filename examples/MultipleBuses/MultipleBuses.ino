@@ -0,0 +1,90 @@
+//======================================================================
+//======================================================================
+//  Program: MultipleBuses.ino
+//
+//  Description: this sketch demonstrates how to read DS18B20 sensors
+//               wired on several ONE WIRE buses with the
+//               NonBlockingDallasManager class. The buses are staggered
+//               so that one bus is read while the others are converting.
+//               https://github.com/Gbertaz/NonBlockingDallas
+//
+//
+//  License:
+//
+//  Copyright(c) 2021 Giovanni Bertazzoni <nottheworstdev@gmail.com>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+//======================================================================
+//======================================================================
+
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include <NonBlockingDallas.h>
+#include <NonBlockingDallasManager.h>           //Include the manager of several buses
+
+#define ONE_WIRE_BUS_A 2                        //PIN of the first ONE WIRE bus
+#define ONE_WIRE_BUS_B 3                        //PIN of the second ONE WIRE bus
+#define TIME_INTERVAL 1500                      //Time interval among sensor readings [milliseconds]
+
+OneWire oneWireA(ONE_WIRE_BUS_A);
+OneWire oneWireB(ONE_WIRE_BUS_B);
+DallasTemperature dallasTempA(&oneWireA);
+DallasTemperature dallasTempB(&oneWireB);
+NonBlockingDallas sensorsA(&dallasTempA);
+NonBlockingDallas sensorsB(&dallasTempB);
+NonBlockingDallasManager temperatureSensors;    //Handles both buses with a single index space
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial)
+    ;
+
+  //Add the buses before calling begin
+  temperatureSensors.addBus(&sensorsA);
+  temperatureSensors.addBus(&sensorsB);
+  temperatureSensors.begin(NonBlockingDallas::resolution_12, TIME_INTERVAL);
+
+  //Callbacks receive the index of the sensor across all the buses
+  temperatureSensors.onTemperatureChange(handleTemperatureChange);
+  temperatureSensors.onDeviceDisconnected(handleDeviceDisconnected);
+}
+
+void loop()
+{
+  temperatureSensors.update();
+}
+
+//Invoked ONLY when the temperature changes between two VALID sensor readings
+void handleTemperatureChange(int deviceIndex, int32_t temperatureRAW)
+{
+  Serial.print(F("[NonBlockingDallasManager] handleTemperatureChange ==> deviceIndex="));
+  Serial.print(deviceIndex);
+  Serial.print(F(" | "));
+  Serial.print(sensorsA.rawToCelsius(temperatureRAW));
+  Serial.println(F("°C"));
+}
+
+//Invoked when the sensor reading fails
+void handleDeviceDisconnected(int deviceIndex)
+{
+  Serial.print(F("[NonBlockingDallasManager] handleDeviceDisconnected ==> deviceIndex="));
+  Serial.print(deviceIndex);
+  Serial.println(F(" disconnected."));
+}
@@ -0,0 +1,85 @@
+// Host build of NonBlockingDallas: checks and helpers shared by the tests.
+// Each test is a program returning the number of failed checks.
+
+#ifndef HostTest_h
+#define HostTest_h
+
+#include <NonBlockingDallas.h>
+
+static int hostFailures = 0;
+
+#define CHECK(condition)                                                         \
+	do                                                                           \
+	{                                                                            \
+		if (!(condition))                                                        \
+		{                                                                        \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			hostFailures++;                                                      \
+		}                                                                        \
+	} while (0)
+
+#define CHECK_EQUAL(expected, actual)                                                           \
+	do                                                                                          \
+	{                                                                                           \
+		long long hostExpected = (long long)(expected);                                        \
+		long long hostActual = (long long)(actual);                                            \
+		if (hostExpected != hostActual)                                                         \
+		{                                                                                       \
+			printf("%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, hostActual, \
+				   hostExpected);                                                               \
+			hostFailures++;                                                                     \
+		}                                                                                       \
+	} while (0)
+
+#define RUN_TEST(test)          \
+	do                          \
+	{                           \
+		printf("%s\n", #test); \
+		test();                 \
+	} while (0)
+
+/**
+ * OneWire bus with its DallasTemperature, the sensors are added to oneWire
+ */
+struct HostBus
+{
+	OneWire oneWire;
+	DallasTemperature dallasTemp;
+
+	HostBus()
+		: oneWire(2), dallasTemp(&oneWire)
+	{
+	}
+};
+
+/**
+ * Calls update() of a bus or of a manager every stepMillis for the given simulated time
+ */
+template <class SENSORS>
+void runFor(SENSORS &sensors, unsigned long durationMillis, unsigned long stepMillis = 1)
+{
+	unsigned long end = millis() + durationMillis;
+	while ((long)(millis() - end) < 0)
+	{
+		sensors.update();
+		host::advanceMillis(stepMillis);
+	}
+}
+
+inline int32_t celsiusToRAW(float celsius)
+{
+	return (int32_t)(celsius * 128);
+}
+
+inline int hostResult()
+{
+	if (hostFailures == 0)
+	{
+		printf("passed\n");
+		return 0;
+	}
+	printf("%d checks failed\n", hostFailures);
+	return 1;
+}
+
+#endif
@@ -0,0 +1,120 @@
+// Host build of NonBlockingDallas: bus time and update() latency of the main configurations,
+// measured on the simulated bus over one minute of simulated time
+
+#include <HostTest.h>
+#include <NonBlockingDallasThresholds.h>
+#include <NonBlockingDallasConversionTimes.h>
+
+struct benchmarkResult
+{
+	uint32_t cycles;
+	unsigned long busMicrosPerCycle;
+	unsigned long slotsPerCycle;
+	unsigned long longestUpdateMicros;
+	unsigned long updateCalls;
+};
+
+static uint32_t completedCycles;
+static NonBlockingDallasThresholdsN<64> thresholds;
+static NonBlockingDallasConversionTimesN<64> conversionTimes; // Learned again by each run
+
+static void handleCycleComplete(const int32_t *, uint8_t, const uint8_t *, const uint8_t *)
+{
+	completedCycles++;
+}
+
+static benchmarkResult run(uint8_t sensorsCount, void (*configure)(NonBlockingDallasBase &))
+{
+	HostBus bus;
+	for (uint8_t i = 1; i <= sensorsCount; i++)
+		bus.oneWire.addSensor(i, 18 + i * 0.25f);
+	NonBlockingDallasN<64> sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.onCycleComplete(handleCycleComplete);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	if (configure)
+		configure(sensors);
+	runFor(sensors, 2000); // First cycles, learning the conversion time
+
+	benchmarkResult result = {0, 0, 0, 0, 0};
+	completedCycles = 0;
+	bus.oneWire.resetCounters();
+	unsigned long end = millis() + 60000;
+	while ((long)(millis() - end) < 0)
+	{
+		unsigned long start = micros();
+		sensors.update();
+		unsigned long elapsed = micros() - start;
+		if (elapsed > result.longestUpdateMicros)
+			result.longestUpdateMicros = elapsed;
+		result.updateCalls++;
+		host::advanceMillis(1);
+	}
+	result.cycles = completedCycles;
+	if (result.cycles > 0)
+	{
+		result.busMicrosPerCycle = bus.oneWire.busMicros / result.cycles;
+		result.slotsPerCycle = bus.oneWire.slots / result.cycles;
+	}
+	return result;
+}
+
+static void defaults(NonBlockingDallasBase &)
+{
+}
+
+static void sliced(NonBlockingDallasBase &sensors)
+{
+	sensors.setReadoutSlice(1);
+}
+
+static void timedWait(NonBlockingDallasBase &sensors)
+{
+	for (uint8_t i = 0; i < conversionTimes.getSensors(); i++)
+		conversionTimes.reset(i);
+	sensors.attachConversionTimes(&conversionTimes);
+	sensors.setTimedWait(true);
+}
+
+static void fastRead(NonBlockingDallasBase &sensors)
+{
+	sensors.setFastRead(8);
+}
+
+static void alarmMode(NonBlockingDallasBase &sensors)
+{
+	sensors.attachThresholds(&thresholds);
+	for (uint8_t i = 0; i < sensors.getSensorsCount(); i++)
+		sensors.setThresholds(i, -20 * 128, 60 * 128);
+	sensors.setAlarmMode(10);
+}
+
+struct benchmark
+{
+	const char *name;
+	void (*configure)(NonBlockingDallasBase &);
+};
+
+int main()
+{
+	static const benchmark benchmarks[] = {
+		{"defaults", defaults},
+		{"setReadoutSlice(1)", sliced},
+		{"setTimedWait(true)", timedWait},
+		{"setFastRead(8)", fastRead},
+		{"setAlarmMode(10)", alarmMode},
+	};
+	static const uint8_t sensorsCounts[] = {1, 4, 16, 64};
+
+	printf("%-20s %8s %8s %14s %12s %16s\n", "configuration", "sensors", "cycles", "bus us/cycle", "slots/cycle", "longest update us");
+	for (const benchmark &b : benchmarks)
+	{
+		for (uint8_t sensorsCount : sensorsCounts)
+		{
+			benchmarkResult result = run(sensorsCount, b.configure);
+			printf("%-20s %8u %8lu %14lu %12lu %16lu\n", b.name, sensorsCount, (unsigned long)result.cycles,
+				   result.busMicrosPerCycle, result.slotsPerCycle, result.longestUpdateMicros);
+		}
+	}
+	printf("\nsizeof(NonBlockingDallas) %u bytes\n", (unsigned)sizeof(NonBlockingDallas));
+	return 0;
+}
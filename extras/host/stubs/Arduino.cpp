@@ -0,0 +1,66 @@
+#include <Arduino.h>
+
+HostSerial Serial;
+
+static unsigned long simulatedMicros = 1000;
+static unsigned long hostDelayedMillis = 0;
+
+// Time source of the library, see NBD_MILLIS in CMakeLists.txt
+unsigned long hostMillis()
+{
+	return simulatedMicros / 1000;
+}
+
+unsigned long hostMicros()
+{
+	return simulatedMicros;
+}
+
+unsigned long millis()
+{
+	return hostMillis();
+}
+
+unsigned long micros()
+{
+	return hostMicros();
+}
+
+void delay(unsigned long ms)
+{
+	simulatedMicros += ms * 1000;
+	hostDelayedMillis += ms;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	simulatedMicros += us;
+}
+
+namespace host
+{
+	void setMicros(unsigned long now)
+	{
+		simulatedMicros = now;
+	}
+
+	void advanceMicros(unsigned long us)
+	{
+		simulatedMicros += us;
+	}
+
+	void advanceMillis(unsigned long ms)
+	{
+		simulatedMicros += ms * 1000;
+	}
+
+	unsigned long delayedMillis()
+	{
+		return hostDelayedMillis;
+	}
+
+	void resetDelayedMillis()
+	{
+		hostDelayedMillis = 0;
+	}
+}
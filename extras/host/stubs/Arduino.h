@@ -0,0 +1,134 @@
+// Host build of NonBlockingDallas: the subset of the Arduino core used by the library,
+// driven by a simulated clock that only moves when the bus or the test makes it move
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define HEX 16
+#define DEC 10
+#define F(string_literal) (string_literal)
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/**
+ * Simulated clock shared by the stubs and the tests
+ */
+namespace host
+{
+	void setMicros(unsigned long now);
+	void advanceMicros(unsigned long us);
+	void advanceMillis(unsigned long ms);
+	unsigned long delayedMillis(); // Sum of the delay() calls since the last reset
+	void resetDelayedMillis();
+}
+
+class String
+{
+public:
+	String(const char *value = "") : _value(value ? value : "") {}
+	String(char value) : _value(1, value) {}
+	String(int value, int base = DEC) { format(value, base); }
+	String(unsigned int value, int base = DEC) { format(value, base); }
+	String(long value, int base = DEC) { format(value, base); }
+	String(unsigned long value, int base = DEC) { format(value, base); }
+	String(unsigned char value, int base = DEC) { format(value, base); }
+
+	String &operator+=(const String &other)
+	{
+		_value += other._value;
+		return *this;
+	}
+	String &operator+=(const char *other)
+	{
+		_value += other;
+		return *this;
+	}
+	String &operator+=(char other)
+	{
+		_value += other;
+		return *this;
+	}
+	bool operator==(const String &other) const { return _value == other._value; }
+	bool operator==(const char *other) const { return _value == other; }
+	char operator[](unsigned int index) const { return index < _value.size() ? _value[index] : 0; }
+	unsigned int length() const { return _value.size(); }
+	bool reserve(unsigned int size)
+	{
+		_value.reserve(size);
+		return true;
+	}
+	const char *c_str() const { return _value.c_str(); }
+
+private:
+	std::string _value;
+
+	void format(unsigned long value, int base)
+	{
+		char buffer[24];
+		snprintf(buffer, sizeof(buffer), base == HEX ? "%lx" : "%lu", value);
+		_value = buffer;
+	}
+	void format(long value, int base)
+	{
+		char buffer[24];
+		if (base == HEX)
+			snprintf(buffer, sizeof(buffer), "%lx", (unsigned long)value);
+		else
+			snprintf(buffer, sizeof(buffer), "%ld", value);
+		_value = buffer;
+	}
+	void format(int value, int base) { format((long)value, base); }
+	void format(unsigned int value, int base) { format((unsigned long)value, base); }
+	void format(unsigned char value, int base) { format((unsigned long)value, base); }
+};
+
+/**
+ * Serial printing to stdout, silent unless enabled by the test
+ */
+class HostSerial
+{
+public:
+	bool enabled = false;
+
+	void begin(unsigned long) {}
+	void print(const char *value) { if (enabled) fputs(value, stdout); }
+	void print(const String &value) { print(value.c_str()); }
+	void print(char value) { if (enabled) putchar(value); }
+	void print(int value, int base = DEC) { print(String(value, base)); }
+	void print(unsigned int value, int base = DEC) { print(String(value, base)); }
+	void print(long value, int base = DEC) { print(String(value, base)); }
+	void print(unsigned long value, int base = DEC) { print(String(value, base)); }
+	void print(unsigned char value, int base = DEC) { print(String(value, base)); }
+	void print(double value, int digits = 2)
+	{
+		if (enabled)
+			printf("%.*f", digits, value);
+	}
+	template <class T>
+	void println(T value)
+	{
+		print(value);
+		println();
+	}
+	void println() { print("\n"); }
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,395 @@
+#include <DallasTemperature.h>
+
+#define STARTCONVO 0x44
+#define COPYSCRATCH 0x48
+#define READSCRATCH 0xBE
+#define WRITESCRATCH 0x4E
+#define READPOWERSUPPLY 0xB4
+
+#define TEMP_LSB 0
+#define TEMP_MSB 1
+#define HIGH_ALARM_TEMP 2
+#define LOW_ALARM_TEMP 3
+#define CONFIGURATION 4
+#define SCRATCHPAD_CRC 8
+
+DallasTemperature::DallasTemperature(OneWire *oneWire)
+	: _wire(oneWire), _parasite(false), _waitForConversion(true), _autoSaveScratchPad(true), _bitResolution(9), _devices(0), _ds18Count(0)
+{
+	resetAlarmSearch();
+}
+
+void DallasTemperature::begin()
+{
+	DeviceAddress deviceAddress;
+	_wire->reset_search();
+	_devices = 0;
+	_ds18Count = 0;
+	while (_wire->search(deviceAddress))
+	{
+		if (!validAddress(deviceAddress))
+			continue;
+		_devices++;
+		if (validFamily(deviceAddress))
+		{
+			_ds18Count++;
+			if (!_parasite && readPowerSupply(deviceAddress))
+				_parasite = true;
+			uint8_t b = getResolution(deviceAddress);
+			if (b > _bitResolution)
+				_bitResolution = b;
+		}
+	}
+}
+
+uint8_t DallasTemperature::getDeviceCount()
+{
+	return _devices;
+}
+
+uint8_t DallasTemperature::getDS18Count()
+{
+	return _ds18Count;
+}
+
+bool DallasTemperature::validAddress(const uint8_t *deviceAddress)
+{
+	return OneWire::crc8(deviceAddress, 7) == deviceAddress[7];
+}
+
+bool DallasTemperature::validFamily(const uint8_t *deviceAddress)
+{
+	switch (deviceAddress[0])
+	{
+	case DS18S20MODEL:
+	case DS18B20MODEL:
+	case DS1822MODEL:
+	case DS1825MODEL:
+	case DS28EA00MODEL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool DallasTemperature::getAddress(uint8_t *deviceAddress, uint8_t index)
+{
+	uint8_t depth = 0;
+	_wire->reset_search();
+	while (depth <= index && _wire->search(deviceAddress))
+	{
+		if (depth == index && validAddress(deviceAddress))
+			return true;
+		depth++;
+	}
+	return false;
+}
+
+bool DallasTemperature::isConnected(const uint8_t *deviceAddress, uint8_t *scratchPad)
+{
+	bool b = readScratchPad(deviceAddress, scratchPad);
+	bool allZeros = true;
+	for (uint8_t i = 0; i < 9; i++)
+		allZeros = allZeros && scratchPad[i] == 0;
+	return b && !allZeros && OneWire::crc8(scratchPad, 8) == scratchPad[SCRATCHPAD_CRC];
+}
+
+bool DallasTemperature::readScratchPad(const uint8_t *deviceAddress, uint8_t *scratchPad)
+{
+	if (_wire->reset() == 0)
+		return false;
+	_wire->select(deviceAddress);
+	_wire->write(READSCRATCH);
+	for (uint8_t i = 0; i < 9; i++)
+		scratchPad[i] = _wire->read();
+	return _wire->reset() == 1;
+}
+
+void DallasTemperature::writeScratchPad(const uint8_t *deviceAddress, const uint8_t *scratchPad)
+{
+	_wire->reset();
+	_wire->select(deviceAddress);
+	_wire->write(WRITESCRATCH);
+	_wire->write(scratchPad[HIGH_ALARM_TEMP]);
+	_wire->write(scratchPad[LOW_ALARM_TEMP]);
+	if (deviceAddress[0] != DS18S20MODEL)
+		_wire->write(scratchPad[CONFIGURATION]);
+	if (_autoSaveScratchPad)
+		saveScratchPad(deviceAddress);
+	else
+		_wire->reset();
+}
+
+bool DallasTemperature::saveScratchPad(const uint8_t *deviceAddress)
+{
+	if (_wire->reset() == 0)
+		return false;
+	if (deviceAddress == nullptr)
+		_wire->skip();
+	else
+		_wire->select(deviceAddress);
+	_wire->write(COPYSCRATCH, _parasite);
+	delay(20); // NV write cycle, 10 ms at most, waited twice as long
+	return _wire->reset() == 1;
+}
+
+bool DallasTemperature::readPowerSupply(const uint8_t *deviceAddress)
+{
+	bool parasiteMode = false;
+	_wire->reset();
+	if (deviceAddress == nullptr)
+		_wire->skip();
+	else
+		_wire->select(deviceAddress);
+	_wire->write(READPOWERSUPPLY);
+	if (_wire->read_bit() == 0)
+		parasiteMode = true;
+	_wire->reset();
+	return parasiteMode;
+}
+
+uint8_t DallasTemperature::getResolution()
+{
+	return _bitResolution;
+}
+
+void DallasTemperature::setResolution(uint8_t newResolution)
+{
+	_bitResolution = constrain(newResolution, 9, 12);
+	DeviceAddress deviceAddress;
+	for (uint8_t i = 0; i < _devices; i++)
+		if (getAddress(deviceAddress, i))
+			setResolution(deviceAddress, _bitResolution, true);
+}
+
+uint8_t DallasTemperature::getResolution(const uint8_t *deviceAddress)
+{
+	if (deviceAddress[0] == DS18S20MODEL)
+		return 12;
+	ScratchPad scratchPad;
+	if (!isConnected(deviceAddress, scratchPad))
+		return 0;
+	switch (scratchPad[CONFIGURATION])
+	{
+	case 0x7F:
+		return 12;
+	case 0x5F:
+		return 11;
+	case 0x3F:
+		return 10;
+	case 0x1F:
+		return 9;
+	default:
+		return 0;
+	}
+}
+
+bool DallasTemperature::setResolution(const uint8_t *deviceAddress, uint8_t newResolution, bool skipGlobalBitResolutionCalculation)
+{
+	bool success = false;
+	newResolution = constrain(newResolution, 9, 12);
+	if (deviceAddress[0] == DS18S20MODEL)
+		success = true;
+	else
+	{
+		ScratchPad scratchPad;
+		if (isConnected(deviceAddress, scratchPad))
+		{
+			uint8_t newValue = ((newResolution - 9) << 5) | 0x1F;
+			if (scratchPad[CONFIGURATION] != newValue)
+			{
+				scratchPad[CONFIGURATION] = newValue;
+				writeScratchPad(deviceAddress, scratchPad);
+			}
+			success = true;
+		}
+	}
+	if (!skipGlobalBitResolutionCalculation && success)
+	{
+		_bitResolution = newResolution;
+		DeviceAddress other;
+		for (uint8_t i = 0; _devices > 1 && i < _devices; i++)
+		{
+			if (getAddress(other, i))
+			{
+				uint8_t b = getResolution(other);
+				if (b > _bitResolution)
+					_bitResolution = b;
+			}
+		}
+	}
+	return success;
+}
+
+void DallasTemperature::setWaitForConversion(bool flag)
+{
+	_waitForConversion = flag;
+}
+
+bool DallasTemperature::getWaitForConversion()
+{
+	return _waitForConversion;
+}
+
+void DallasTemperature::setAutoSaveScratchPad(bool flag)
+{
+	_autoSaveScratchPad = flag;
+}
+
+bool DallasTemperature::getAutoSaveScratchPad()
+{
+	return _autoSaveScratchPad;
+}
+
+void DallasTemperature::requestTemperatures()
+{
+	_wire->reset();
+	_wire->skip();
+	_wire->write(STARTCONVO, _parasite);
+	if (_waitForConversion)
+		blockTillConversionComplete(_bitResolution);
+}
+
+bool DallasTemperature::requestTemperaturesByAddress(const uint8_t *deviceAddress)
+{
+	uint8_t bitResolution = getResolution(deviceAddress);
+	if (bitResolution == 0)
+		return false;
+	_wire->reset();
+	_wire->select(deviceAddress);
+	_wire->write(STARTCONVO, _parasite);
+	if (_waitForConversion)
+		blockTillConversionComplete(bitResolution);
+	return true;
+}
+
+void DallasTemperature::blockTillConversionComplete(uint8_t bitResolution)
+{
+	if (_parasite)
+	{
+		delay(750 >> (12 - bitResolution));
+		return;
+	}
+	unsigned long start = millis();
+	while (!isConversionComplete() && millis() - start < 750)
+		;
+}
+
+bool DallasTemperature::isConversionComplete()
+{
+	return _wire->read_bit() == 1;
+}
+
+int32_t DallasTemperature::getTemp(const uint8_t *deviceAddress)
+{
+	ScratchPad scratchPad;
+	if (isConnected(deviceAddress, scratchPad))
+		return calculateTemperature(deviceAddress, scratchPad);
+	return DEVICE_DISCONNECTED_RAW;
+}
+
+float DallasTemperature::getTempC(const uint8_t *deviceAddress)
+{
+	return rawToCelsius(getTemp(deviceAddress));
+}
+
+int32_t DallasTemperature::calculateTemperature(const uint8_t *, const uint8_t *scratchPad)
+{
+	int32_t neg = (scratchPad[TEMP_MSB] & 0x80) ? (int32_t)0xFFF80000 : 0;
+	return (((int32_t)scratchPad[TEMP_MSB]) << 11) | (((int32_t)scratchPad[TEMP_LSB]) << 3) | neg;
+}
+
+float DallasTemperature::rawToCelsius(int32_t raw)
+{
+	if (raw <= DEVICE_DISCONNECTED_RAW)
+		return DEVICE_DISCONNECTED_C;
+	return (float)raw * 0.0078125f;
+}
+
+bool DallasTemperature::isParasitePowerMode()
+{
+	return _parasite;
+}
+
+void DallasTemperature::setHighAlarmTemp(const uint8_t *deviceAddress, int8_t celsius)
+{
+	celsius = constrain(celsius, -55, 125);
+	ScratchPad scratchPad;
+	if (isConnected(deviceAddress, scratchPad))
+	{
+		scratchPad[HIGH_ALARM_TEMP] = (uint8_t)celsius;
+		writeScratchPad(deviceAddress, scratchPad);
+	}
+}
+
+void DallasTemperature::setLowAlarmTemp(const uint8_t *deviceAddress, int8_t celsius)
+{
+	celsius = constrain(celsius, -55, 125);
+	ScratchPad scratchPad;
+	if (isConnected(deviceAddress, scratchPad))
+	{
+		scratchPad[LOW_ALARM_TEMP] = (uint8_t)celsius;
+		writeScratchPad(deviceAddress, scratchPad);
+	}
+}
+
+void DallasTemperature::resetAlarmSearch()
+{
+	_alarmSearchJunction = -1;
+	_alarmSearchExhausted = 0;
+	memset(_alarmSearchAddress, 0, sizeof(_alarmSearchAddress));
+}
+
+bool DallasTemperature::alarmSearch(uint8_t *newAddr)
+{
+	int8_t lastJunction = -1;
+	uint8_t done = 1;
+	if (_alarmSearchExhausted)
+		return false;
+	if (!_wire->reset())
+		return false;
+	_wire->write(0xEC, 0); // Alarm search
+	for (uint8_t i = 0; i < 64; i++)
+	{
+		uint8_t a = _wire->read_bit();
+		uint8_t nota = _wire->read_bit();
+		uint8_t ibyte = i / 8;
+		uint8_t ibit = 1 << (i & 7);
+		if (a && nota)
+			return false; // No device answered
+		if (!a && !nota)
+		{
+			if (i == _alarmSearchJunction)
+			{
+				a = 1;
+				_alarmSearchJunction = lastJunction;
+			}
+			else if (i < _alarmSearchJunction)
+			{
+				if (_alarmSearchAddress[ibyte] & ibit)
+					a = 1;
+				else
+				{
+					a = 0;
+					done = 0;
+					lastJunction = i;
+				}
+			}
+			else
+			{
+				a = 0;
+				_alarmSearchJunction = i;
+				done = 0;
+			}
+		}
+		if (a)
+			_alarmSearchAddress[ibyte] |= ibit;
+		else
+			_alarmSearchAddress[ibyte] &= ~ibit;
+		_wire->write_bit(a);
+	}
+	if (done)
+		_alarmSearchExhausted = 1;
+	memcpy(newAddr, _alarmSearchAddress, 8);
+	return true;
+}
@@ -0,0 +1,74 @@
+// Host build of NonBlockingDallas: the subset of DallasTemperature used by the library, issuing
+// the same 1-Wire transactions as the real one so that the simulated bus sees the same cost
+
+#ifndef DallasTemperature_h
+#define DallasTemperature_h
+
+#include <OneWire.h>
+
+#define DS18S20MODEL 0x10
+#define DS18B20MODEL 0x28
+#define DS1822MODEL 0x22
+#define DS1825MODEL 0x3B
+#define DS28EA00MODEL 0x42
+
+#define DEVICE_DISCONNECTED_C -127
+#define DEVICE_DISCONNECTED_F -196.6
+#define DEVICE_DISCONNECTED_RAW -7040
+
+typedef uint8_t DeviceAddress[8];
+typedef uint8_t ScratchPad[9];
+
+class DallasTemperature
+{
+public:
+	DallasTemperature(OneWire *oneWire);
+
+	void begin();
+	uint8_t getDeviceCount();
+	uint8_t getDS18Count();
+	bool validAddress(const uint8_t *deviceAddress);
+	bool validFamily(const uint8_t *deviceAddress);
+	bool getAddress(uint8_t *deviceAddress, uint8_t index);
+	bool isConnected(const uint8_t *deviceAddress, uint8_t *scratchPad);
+	bool readScratchPad(const uint8_t *deviceAddress, uint8_t *scratchPad);
+	void writeScratchPad(const uint8_t *deviceAddress, const uint8_t *scratchPad);
+	bool saveScratchPad(const uint8_t *deviceAddress = nullptr);
+	bool readPowerSupply(const uint8_t *deviceAddress = nullptr);
+	uint8_t getResolution();
+	void setResolution(uint8_t newResolution);
+	uint8_t getResolution(const uint8_t *deviceAddress);
+	bool setResolution(const uint8_t *deviceAddress, uint8_t newResolution, bool skipGlobalBitResolutionCalculation = false);
+	void setWaitForConversion(bool flag);
+	bool getWaitForConversion();
+	void setAutoSaveScratchPad(bool flag);
+	bool getAutoSaveScratchPad();
+	void requestTemperatures();
+	bool requestTemperaturesByAddress(const uint8_t *deviceAddress);
+	bool isConversionComplete();
+	int32_t getTemp(const uint8_t *deviceAddress);
+	float getTempC(const uint8_t *deviceAddress);
+	bool isParasitePowerMode();
+	void setHighAlarmTemp(const uint8_t *deviceAddress, int8_t celsius);
+	void setLowAlarmTemp(const uint8_t *deviceAddress, int8_t celsius);
+	void resetAlarmSearch();
+	bool alarmSearch(uint8_t *newAddr);
+	static int32_t calculateTemperature(const uint8_t *deviceAddress, const uint8_t *scratchPad);
+	static float rawToCelsius(int32_t raw);
+
+private:
+	OneWire *_wire;
+	bool _parasite;
+	bool _waitForConversion;
+	bool _autoSaveScratchPad;
+	uint8_t _bitResolution;
+	uint8_t _devices;
+	uint8_t _ds18Count;
+	uint8_t _alarmSearchAddress[8];
+	int8_t _alarmSearchJunction;
+	uint8_t _alarmSearchExhausted;
+
+	void blockTillConversionComplete(uint8_t bitResolution);
+};
+
+#endif
@@ -0,0 +1,457 @@
+#include <OneWire.h>
+
+void SimulatedSensor::setCelsius(float celsius)
+{
+	temperature = (int16_t)(celsius * 16 + (celsius < 0 ? -0.5f : 0.5f));
+}
+
+uint8_t SimulatedSensor::resolution() const
+{
+	return ((scratchPad[4] >> 5) & 3) + 9;
+}
+
+void SimulatedSensor::powerOnReset()
+{
+	scratchPad[0] = 0x50; // 85 °C
+	scratchPad[1] = 0x05;
+	scratchPad[2] = eeprom[0];
+	scratchPad[3] = eeprom[1];
+	scratchPad[4] = eeprom[2];
+	converting = false;
+}
+
+OneWire::OneWire(uint8_t)
+	: shorted(false), resets(0), slots(0), busMicros(0), protocolErrors(0), _mode(modeIdle), _position(0), _complement(false)
+{
+	reset_search();
+}
+
+SimulatedSensor &OneWire::addSensor(uint8_t id, float celsius)
+{
+	SimulatedSensor sensor;
+	memset(&sensor, 0, sizeof(sensor));
+	sensor.rom[0] = 0x28;
+	sensor.rom[1] = id;
+	for (uint8_t i = 2; i < 7; i++)
+		sensor.rom[i] = (uint8_t)(id * 37 + i * 11);
+	sensor.rom[7] = crc8(sensor.rom, 7);
+	sensor.eeprom[0] = 0x4B; // Factory TH, TL and 12 bits
+	sensor.eeprom[1] = 0x46;
+	sensor.eeprom[2] = 0x7F;
+	sensor.scratchPad[5] = 0xFF;
+	sensor.scratchPad[6] = 0x0C;
+	sensor.scratchPad[7] = 0x10;
+	sensor.present = true;
+	sensor.powerOnReset();
+	sensor.setCelsius(celsius);
+	_sensors.push_back(sensor);
+	return _sensors.back();
+}
+
+SimulatedSensor &OneWire::sensor(uint8_t index)
+{
+	return _sensors[index];
+}
+
+uint8_t OneWire::sensorsCount()
+{
+	return _sensors.size();
+}
+
+void OneWire::removeSensor(uint8_t index)
+{
+	_sensors.erase(_sensors.begin() + index);
+	_selected.clear();
+	_mode = modeIdle;
+}
+
+void OneWire::resetCounters()
+{
+	resets = 0;
+	slots = 0;
+	busMicros = 0;
+	protocolErrors = 0;
+}
+
+void OneWire::slot()
+{
+	slots++;
+	busMicros += ONEWIRE_SLOT_MICROS;
+	host::advanceMicros(ONEWIRE_SLOT_MICROS);
+}
+
+void OneWire::latch(SimulatedSensor &sensor)
+{
+	if (!sensor.converting || (long)(micros() - sensor.conversionEnd) < 0)
+		return;
+	sensor.converting = false;
+	int16_t value = sensor.temperature & ~((1 << (12 - sensor.resolution())) - 1); // Undefined bits read as 0
+	sensor.scratchPad[0] = value & 0xFF;
+	sensor.scratchPad[1] = (value >> 8) & 0xFF;
+}
+
+bool OneWire::isAlarmed(SimulatedSensor &sensor)
+{
+	latch(sensor);
+	int8_t degrees = (int16_t)((sensor.scratchPad[1] << 8) | sensor.scratchPad[0]) >> 4;
+	return degrees >= (int8_t)sensor.scratchPad[2] || degrees <= (int8_t)sensor.scratchPad[3];
+}
+
+uint8_t OneWire::romBit(const SimulatedSensor &sensor)
+{
+	return (sensor.rom[_position >> 3] >> (_position & 7)) & 1;
+}
+
+void OneWire::selectAll(bool alarmOnly)
+{
+	_selected.clear();
+	for (uint8_t i = 0; i < _sensors.size(); i++)
+		if (_sensors[i].present && (!alarmOnly || isAlarmed(_sensors[i])))
+			_selected.push_back(i);
+}
+
+uint8_t OneWire::reset()
+{
+	resets++;
+	busMicros += ONEWIRE_RESET_MICROS;
+	host::advanceMicros(ONEWIRE_RESET_MICROS);
+	if (_mode == modeReadScratchPad && _position > 0) // The reset ends the read, corrupted or not
+		for (uint8_t i : _selected)
+			if (_sensors[i].corruptReads > 0)
+				_sensors[i].corruptReads--;
+	_selected.clear();
+	bool presence = false;
+	for (SimulatedSensor &sensor : _sensors)
+		presence = presence || sensor.present;
+	presence = presence && !shorted;
+	_mode = presence ? modeRomCommand : modeIdle;
+	return presence;
+}
+
+void OneWire::select(const uint8_t rom[8])
+{
+	write(0x55); // Match ROM
+	for (uint8_t i = 0; i < 8; i++)
+		write(rom[i]);
+}
+
+void OneWire::skip()
+{
+	write(0xCC); // Skip ROM
+}
+
+void OneWire::function(uint8_t command)
+{
+	switch (command)
+	{
+	case 0x44: // Convert T
+		for (uint8_t i : _selected)
+		{
+			SimulatedSensor &sensor = _sensors[i];
+			latch(sensor);
+			sensor.converting = true;
+			sensor.conversionEnd = micros() + (93750UL << (sensor.resolution() - 9)) + sensor.extraConversionMicros;
+			sensor.conversions++;
+		}
+		_mode = modeConverting;
+		break;
+	case 0xBE: // Read scratchpad
+		for (uint8_t i : _selected)
+		{
+			SimulatedSensor &sensor = _sensors[i];
+			latch(sensor);
+			sensor.scratchPad[8] = crc8(sensor.scratchPad, 8);
+			sensor.scratchPadReads++;
+		}
+		_position = 0;
+		_mode = modeReadScratchPad;
+		break;
+	case 0x4E: // Write scratchpad
+		_position = 2;
+		_mode = modeWriteScratchPad;
+		break;
+	case 0x48: // Copy scratchpad
+		for (uint8_t i : _selected)
+		{
+			SimulatedSensor &sensor = _sensors[i];
+			memcpy(sensor.eeprom, &sensor.scratchPad[2], 3);
+			sensor.eepromWrites++;
+		}
+		_mode = modeIdle;
+		break;
+	case 0xB8: // Recall EEPROM
+		for (uint8_t i : _selected)
+			memcpy(&_sensors[i].scratchPad[2], _sensors[i].eeprom, 3);
+		_mode = modeIdle;
+		break;
+	case 0xB4: // Read power supply
+		_mode = modePowerSupply;
+		break;
+	default:
+		_mode = modeIdle;
+		break;
+	}
+}
+
+void OneWire::write(uint8_t v, uint8_t)
+{
+	for (uint8_t i = 0; i < 8; i++)
+		slot();
+	switch (_mode)
+	{
+	case modeRomCommand:
+		if (v == 0x55)
+		{
+			_position = 0;
+			_mode = modeMatchRom;
+		}
+		else if (v == 0xCC)
+		{
+			selectAll(false);
+			_mode = modeFunction;
+		}
+		else if (v == 0xF0 || v == 0xEC)
+		{
+			selectAll(v == 0xEC);
+			_position = 0;
+			_complement = false;
+			_mode = modeSearch;
+		}
+		else
+			_mode = modeIdle;
+		break;
+	case modeMatchRom:
+		_matchRom[_position++] = v;
+		if (_position == 8)
+		{
+			for (uint8_t i = 0; i < _sensors.size(); i++)
+				if (_sensors[i].present && memcmp(_sensors[i].rom, _matchRom, 8) == 0)
+					_selected.push_back(i);
+			_mode = modeFunction;
+		}
+		break;
+	case modeFunction:
+		function(v);
+		break;
+	case modeWriteScratchPad:
+		for (uint8_t i : _selected)
+			_sensors[i].scratchPad[_position] = _position == 4 ? (v & 0x60) | 0x1F : v;
+		if (++_position > 4)
+			_mode = modeIdle;
+		break;
+	default:
+		break;
+	}
+}
+
+void OneWire::write_bytes(const uint8_t *buf, uint16_t count, bool power)
+{
+	for (uint16_t i = 0; i < count; i++)
+		write(buf[i], power);
+}
+
+uint8_t OneWire::read()
+{
+	for (uint8_t i = 0; i < 8; i++)
+		slot();
+	if (_mode != modeReadScratchPad || _position >= 9)
+		return 0xFF;
+	uint8_t value = 0xFF; // Wired-AND of the sensors answering
+	for (uint8_t i : _selected)
+	{
+		SimulatedSensor &sensor = _sensors[i];
+		uint8_t byte = sensor.scratchPad[_position];
+		if (sensor.corruptReads > 0 && _position == 0)
+			byte ^= 0x08;
+		value &= byte;
+	}
+	_position++;
+	return value;
+}
+
+void OneWire::read_bytes(uint8_t *buf, uint16_t count)
+{
+	for (uint16_t i = 0; i < count; i++)
+		buf[i] = read();
+}
+
+void OneWire::write_bit(uint8_t v)
+{
+	slot();
+	if (_mode == modeRomCommand)
+		protocolErrors++;
+	if (_mode != modeSearch)
+		return;
+	std::vector<uint8_t> remaining;
+	for (uint8_t i : _selected)
+		if (romBit(_sensors[i]) == (v & 1))
+			remaining.push_back(i);
+	_selected = remaining;
+	_complement = false;
+	if (++_position == 64)
+		_mode = modeFunction;
+}
+
+uint8_t OneWire::read_bit()
+{
+	slot();
+	if (_mode == modeRomCommand)
+		protocolErrors++;
+	uint8_t value = 1;
+	switch (_mode)
+	{
+	case modeSearch:
+		for (uint8_t i : _selected)
+			value &= romBit(_sensors[i]) ^ (_complement ? 1 : 0);
+		_complement = !_complement;
+		break;
+	case modeConverting:
+		for (uint8_t i : _selected)
+		{
+			latch(_sensors[i]);
+			if (_sensors[i].converting)
+				value = 0;
+		}
+		break;
+	case modePowerSupply:
+		for (uint8_t i : _selected)
+			if (_sensors[i].parasite)
+				value = 0;
+		break;
+	default:
+		break;
+	}
+	return value;
+}
+
+void OneWire::depower()
+{
+}
+
+void OneWire::reset_search()
+{
+	_lastDiscrepancy = 0;
+	_lastDeviceFlag = false;
+	_lastFamilyDiscrepancy = 0;
+	memset(_searchRom, 0, sizeof(_searchRom));
+}
+
+void OneWire::target_search(uint8_t family_code)
+{
+	_searchRom[0] = family_code;
+	memset(&_searchRom[1], 0, 7);
+	_lastDiscrepancy = 64;
+	_lastFamilyDiscrepancy = 0;
+	_lastDeviceFlag = false;
+}
+
+bool OneWire::search(uint8_t *newAddr, bool search_mode)
+{
+	uint8_t idBitNumber = 1;
+	uint8_t lastZero = 0;
+	uint8_t romByteNumber = 0;
+	uint8_t romByteMask = 1;
+	bool searchResult = false;
+
+	if (!_lastDeviceFlag)
+	{
+		if (!reset())
+		{
+			reset_search();
+			return false;
+		}
+		write(search_mode ? 0xF0 : 0xEC);
+		do
+		{
+			uint8_t idBit = read_bit();
+			uint8_t cmpIdBit = read_bit();
+			if (idBit == 1 && cmpIdBit == 1)
+				break;
+			uint8_t direction;
+			if (idBit != cmpIdBit)
+				direction = idBit;
+			else
+			{
+				if (idBitNumber < _lastDiscrepancy)
+					direction = (_searchRom[romByteNumber] & romByteMask) > 0;
+				else
+					direction = idBitNumber == _lastDiscrepancy;
+				if (direction == 0)
+				{
+					lastZero = idBitNumber;
+					if (lastZero < 9)
+						_lastFamilyDiscrepancy = lastZero;
+				}
+			}
+			if (direction == 1)
+				_searchRom[romByteNumber] |= romByteMask;
+			else
+				_searchRom[romByteNumber] &= ~romByteMask;
+			write_bit(direction);
+			idBitNumber++;
+			romByteMask <<= 1;
+			if (romByteMask == 0)
+			{
+				romByteNumber++;
+				romByteMask = 1;
+			}
+		} while (romByteNumber < 8);
+
+		if (idBitNumber == 65)
+		{
+			_lastDiscrepancy = lastZero;
+			if (_lastDiscrepancy == 0)
+				_lastDeviceFlag = true;
+			searchResult = true;
+		}
+	}
+	if (!searchResult || !_searchRom[0])
+	{
+		reset_search();
+		return false;
+	}
+	memcpy(newAddr, _searchRom, 8);
+	return true;
+}
+
+uint8_t OneWire::crc8(const uint8_t *addr, uint8_t len)
+{
+	uint8_t crc = 0;
+	while (len--)
+	{
+		uint8_t inbyte = *addr++;
+		for (uint8_t i = 8; i; i--)
+		{
+			uint8_t mix = (crc ^ inbyte) & 0x01;
+			crc >>= 1;
+			if (mix)
+				crc ^= 0x8C;
+			inbyte >>= 1;
+		}
+	}
+	return crc;
+}
+
+bool OneWire::check_crc16(const uint8_t *input, uint16_t len, const uint8_t *inverted_crc, uint16_t crc)
+{
+	crc = ~crc16(input, len, crc);
+	return (crc & 0xFF) == inverted_crc[0] && (crc >> 8) == inverted_crc[1];
+}
+
+uint16_t OneWire::crc16(const uint8_t *input, uint16_t len, uint16_t crc)
+{
+	static const uint8_t oddparity[16] = {0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0};
+	for (uint16_t i = 0; i < len; i++)
+	{
+		uint16_t cdata = input[i];
+		cdata = (cdata ^ crc) & 0xff;
+		crc >>= 8;
+		if (oddparity[cdata & 0x0F] ^ oddparity[cdata >> 4])
+			crc ^= 0xC001;
+		cdata <<= 6;
+		crc ^= cdata;
+		cdata <<= 1;
+		crc ^= cdata;
+	}
+	return crc;
+}
@@ -0,0 +1,114 @@
+// Host build of NonBlockingDallas: OneWire bus simulated at the level of the time slots.
+// Each bus holds DS18B20 models answering the ROM and function commands the way the real
+// devices do, wired-AND included, and advances the simulated clock by the duration of every
+// reset and slot. The faults of a real bus are injected per sensor or on the whole bus.
+
+#ifndef OneWire_h
+#define OneWire_h
+
+#include <Arduino.h>
+#include <deque>
+#include <vector>
+
+#define ONEWIRE_RESET_MICROS 960 // Reset pulse and presence window
+#define ONEWIRE_SLOT_MICROS 65	 // Read or write time slot
+
+/**
+ * DS18B20 on the simulated bus
+ */
+struct SimulatedSensor
+{
+	uint8_t rom[8];
+	int16_t temperature;	   // Temperature measured by the next conversion [1/16 °C]
+	uint8_t scratchPad[9];	   // Last CRC byte computed when read
+	uint8_t eeprom[3];		   // TH, TL, configuration
+	unsigned long conversionEnd; // micros() at the end of the conversion in progress
+	bool converting;
+
+	// Faults
+	bool present;				   // Answers to the reset pulse and to the commands
+	bool parasite;				   // Powered by the data line, reported by Read Power Supply
+	uint16_t corruptReads;		   // Next scratchpad reads returned with a flipped bit
+	unsigned long extraConversionMicros; // Added to the datasheet conversion time
+
+	// Counters
+	uint32_t conversions;
+	uint32_t scratchPadReads;
+	uint32_t eepromWrites;
+
+	void setCelsius(float celsius);
+	uint8_t resolution() const; // From the configuration register [bits]
+	void powerOnReset();		// Reloads the EEPROM, temperature register back to 85 °C
+};
+
+class OneWire
+{
+public:
+	OneWire(uint8_t pin);
+
+	// Simulation
+	SimulatedSensor &addSensor(uint8_t id, float celsius);
+	SimulatedSensor &sensor(uint8_t index);
+	uint8_t sensorsCount();
+	void removeSensor(uint8_t index);
+	bool shorted;				  // The bus is held low, no presence pulse
+	uint32_t resets;			  // Reset pulses sent
+	uint32_t slots;				  // Time slots sent
+	unsigned long busMicros;	  // Time spent by resets and slots [microseconds]
+	uint32_t protocolErrors;	  // Bit slots sent while the devices wait for a ROM command byte
+	void resetCounters();
+
+	// OneWire API
+	uint8_t reset();
+	void select(const uint8_t rom[8]);
+	void skip();
+	void write(uint8_t v, uint8_t power = 0);
+	void write_bytes(const uint8_t *buf, uint16_t count, bool power = 0);
+	uint8_t read();
+	void read_bytes(uint8_t *buf, uint16_t count);
+	void write_bit(uint8_t v);
+	uint8_t read_bit();
+	void depower();
+	void reset_search();
+	void target_search(uint8_t family_code);
+	bool search(uint8_t *newAddr, bool search_mode = true);
+	static uint8_t crc8(const uint8_t *addr, uint8_t len);
+	static bool check_crc16(const uint8_t *input, uint16_t len, const uint8_t *inverted_crc, uint16_t crc = 0);
+	static uint16_t crc16(const uint8_t *input, uint16_t len, uint16_t crc = 0);
+
+private:
+	enum busMode
+	{
+		modeIdle,
+		modeRomCommand,
+		modeMatchRom,
+		modeFunction,
+		modeSearch,
+		modeReadScratchPad,
+		modeWriteScratchPad,
+		modeConverting,
+		modePowerSupply
+	};
+
+	std::deque<SimulatedSensor> _sensors; // Grows without moving the sensors already added
+	std::vector<uint8_t> _selected; // Sensors answering to the current function command
+	busMode _mode;
+	uint8_t _position;	 // Byte of the ROM or of the scratchpad, bit of the search
+	bool _complement;	 // The next search read slot returns the complement of the bit
+	uint8_t _matchRom[8];
+
+	// Search state of the OneWire library
+	uint8_t _searchRom[8];
+	uint8_t _lastDiscrepancy;
+	uint8_t _lastFamilyDiscrepancy;
+	bool _lastDeviceFlag;
+
+	void slot();
+	void selectAll(bool alarmOnly);
+	void latch(SimulatedSensor &sensor);
+	void function(uint8_t command);
+	bool isAlarmed(SimulatedSensor &sensor);
+	uint8_t romBit(const SimulatedSensor &sensor);
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include <HostTest.h>
+#include <NonBlockingDallasAdaptive.h>
+
+static unsigned long readingMillis[64];
+static uint8_t readingsCount;
+
+static void handleIntervalElapsed(int, int32_t)
+{
+	if (readingsCount < 64)
+		readingMillis[readingsCount++] = millis();
+}
+
+// Time among the readings i - 1 and i, the conversion time cancels out
+static unsigned long gap(uint8_t i)
+{
+	return readingMillis[i] - readingMillis[i - 1];
+}
+
+static bool near(unsigned long expected, unsigned long actual)
+{
+	return actual + 10 >= expected && actual <= expected + 10;
+}
+
+static void growsWhileStable()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasAdaptiveN<ONE_WIRE_MAX_DEV> adaptive;
+	sensors.attachAdaptive(&adaptive);
+	sensors.onIntervalElapsed(handleIntervalElapsed);
+	sensors.setAdaptiveInterval(1000, 8000, 8, 0);
+	readingsCount = 0;
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 45000);
+
+	// Each reading stretches the interval by half, the next conversion is moved accordingly
+	unsigned long interval = 1000;
+	CHECK(readingsCount >= 9);
+	for (uint8_t i = 1; i < readingsCount; i++)
+	{
+		interval += interval / 2;
+		if (interval > 8000)
+			interval = 8000;
+		if (!near(interval, gap(i)))
+			printf("reading %u: %lu ms after the previous one, expected %lu\n", i, gap(i), interval);
+		CHECK(near(interval, gap(i)));
+	}
+	CHECK_EQUAL(8000, sensors.getSensorInterval(0));
+}
+
+static void dropsToTheMinimumOnChange()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasAdaptiveN<ONE_WIRE_MAX_DEV> adaptive;
+	sensors.attachAdaptive(&adaptive);
+	sensors.onIntervalElapsed(handleIntervalElapsed);
+	sensors.setAdaptiveInterval(1000, 8000, 8, 0);
+	readingsCount = 0;
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 30000);
+	CHECK_EQUAL(8000, sensors.getSensorInterval(0));
+
+	// The reading after the change comes at the long interval, the next one at the minimum
+	uint8_t changed = readingsCount;
+	sensor.setCelsius(25);
+	runFor(sensors, 10000);
+	CHECK(readingsCount >= changed + 2);
+	CHECK(near(8000, gap(changed)));
+	CHECK(near(1000, gap(changed + 1)));
+
+	// Stable again, it grows back
+	CHECK(near(1500, gap(changed + 2)));
+}
+
+static void needsTheAdaptiveState()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.onIntervalElapsed(handleIntervalElapsed);
+	sensors.setAdaptiveInterval(1000, 8000, 8, 0);
+	readingsCount = 0;
+	sensors.begin(NonBlockingDallas::resolution_12, 2000);
+	runFor(sensors, 20000);
+	CHECK(readingsCount >= 9);
+	for (uint8_t i = 1; i < readingsCount; i++)
+		CHECK(near(2000, gap(i)));
+	CHECK_EQUAL(2000, sensors.getSensorInterval(0));
+}
+
+int main()
+{
+	RUN_TEST(growsWhileStable);
+	RUN_TEST(dropsToTheMinimumOnChange);
+	RUN_TEST(needsTheAdaptiveState);
+	return hostResult();
+}
@@ -0,0 +1,90 @@
+#include <HostTest.h>
+
+static const DeviceAddress sample = {0x28, 0xFF, 0x64, 0x1E, 0x0F, 0x1B, 0x2C, 0x3D};
+
+// Resolved at compile time, a bad digit would not build
+static constexpr NonBlockingDallasAddress literal("28ff641e0f1b2c3d");
+static constexpr NonBlockingDallasAddress upperLiteral("28FF641E0F1B2C3D");
+static_assert(literal.bytes[0] == 0x28 && literal.bytes[1] == 0xFF && literal.bytes[7] == 0x3D, "literal address");
+static_assert(upperLiteral.bytes[3] == 0x1E && upperLiteral.bytes[6] == 0x2C, "upper case literal address");
+
+static void roundTrips()
+{
+	char addressString[17];
+	NonBlockingDallas::formatAddress(sample, addressString);
+	CHECK(strcmp("28ff641e0f1b2c3d", addressString) == 0);
+
+	DeviceAddress parsed;
+	CHECK(NonBlockingDallas::parseAddress(addressString, parsed));
+	CHECK(memcmp(sample, parsed, 8) == 0);
+	CHECK(NonBlockingDallas::parseAddress("28FF641E0F1B2C3D", parsed));
+	CHECK(memcmp(sample, parsed, 8) == 0);
+
+	CHECK(memcmp(sample, literal.bytes, 8) == 0);
+	CHECK(memcmp(sample, upperLiteral.bytes, 8) == 0);
+	NonBlockingDallas::formatAddress(literal, addressString);
+	CHECK(strcmp("28ff641e0f1b2c3d", addressString) == 0);
+
+	HostBus bus;
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	String converted = sensors.convertDeviceAddressToString(sample);
+	CHECK(strcmp("28ff641e0f1b2c3d", converted.c_str()) == 0);
+	memset(parsed, 0, 8);
+	CHECK(sensors.convertDeviceAddressStringToDeviceAddress(converted, parsed));
+	CHECK(memcmp(sample, parsed, 8) == 0);
+}
+
+static void rejectsMalformedStrings()
+{
+	const char *const malformed[] = {
+		"",
+		"28ff641e0f1b2c3",	 // 15 digits
+		"28ff641e0f1b2c3d0", // 17 digits
+		"28ff641e0f1b2c3g",
+		"28ff641e0f1b2c 3d",
+		"28:ff:64:1e:0f:1b:2c:3d",
+		"0x28ff641e0f1b2c",
+		"28ff641e-f1b2c3d",
+	};
+	DeviceAddress parsed;
+	for (uint8_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++)
+	{
+		memcpy(parsed, sample, 8);
+		if (NonBlockingDallas::parseAddress(malformed[i], parsed))
+			printf("\"%s\" parsed\n", malformed[i]);
+		CHECK(!NonBlockingDallas::parseAddress(malformed[i], parsed));
+		CHECK(memcmp(sample, parsed, 8) == 0); // Left untouched
+	}
+	CHECK(!NonBlockingDallas::parseAddress(NULL, parsed));
+
+	HostBus bus;
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	CHECK(!sensors.convertDeviceAddressStringToDeviceAddress(String("28ff641e0f1b2c3"), parsed));
+	CHECK(!sensors.convertDeviceAddressStringToDeviceAddress(String("28ff641e0f1b2cXX"), parsed));
+	CHECK(memcmp(sample, parsed, 8) == 0);
+}
+
+static void readsByTheLiteral()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 21.5f);
+	bus.oneWire.addSensor(2, 30);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+
+	constexpr NonBlockingDallasAddress first("28013b46515c6738"); // The ROM of the simulated sensor 1
+	CHECK(memcmp(sensor.rom, first.bytes, 8) == 0);
+	CHECK_EQUAL(celsiusToRAW(21.5f), sensors.getTemperatureRAW(first));
+	CHECK_EQUAL(celsiusToRAW(21.5f), sensors.getTemperatureRAW("28013B46515C6738"));
+	CHECK_EQUAL(DEVICE_DISCONNECTED_RAW, sensors.getTemperatureRAW(literal)); // Not on this bus
+	CHECK_EQUAL(DEVICE_DISCONNECTED_RAW, sensors.getTemperatureRAW("28013b46515c673")); // Malformed
+}
+
+int main()
+{
+	RUN_TEST(roundTrips);
+	RUN_TEST(rejectsMalformedStrings);
+	RUN_TEST(readsByTheLiteral);
+	return hostResult();
+}
@@ -0,0 +1,75 @@
+#include <HostTest.h>
+#include <NonBlockingDallasThresholds.h>
+
+static void programsTheAlarmRegisters()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	bus.oneWire.addSensor(2, 21);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasThresholdsN<ONE_WIRE_MAX_DEV> thresholds;
+	sensors.attachThresholds(&thresholds);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	sensors.setAlarmMode(4);
+	int8_t index = sensors.getIndex(sensor.rom);
+	CHECK(sensors.setThresholds(index, celsiusToRAW(-10), celsiusToRAW(30)));
+	runFor(sensors, 2000);
+	CHECK_EQUAL(30, (int8_t)sensor.scratchPad[2]);
+	CHECK_EQUAL(-10, (int8_t)sensor.scratchPad[3]);
+}
+
+static void readsOnlyTheAlarmedSensors()
+{
+	HostBus bus;
+	SimulatedSensor &hot = bus.oneWire.addSensor(1, 20);
+	SimulatedSensor &cold = bus.oneWire.addSensor(2, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasThresholdsN<ONE_WIRE_MAX_DEV> thresholds;
+	sensors.attachThresholds(&thresholds);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	sensors.setAlarmMode(100);
+	for (uint8_t i = 0; i < 2; i++)
+		sensors.setThresholds(i, celsiusToRAW(0), celsiusToRAW(40));
+	runFor(sensors, 3000);
+
+	hot.setCelsius(50);
+	cold.setCelsius(25);
+	uint32_t coldReads = cold.scratchPadReads;
+	runFor(sensors, 3000);
+	CHECK_EQUAL(celsiusToRAW(50), sensors.getTemperatureRAW(sensors.getIndex(hot.rom)));
+	CHECK_EQUAL(coldReads, cold.scratchPadReads); // Not alarmed, not read
+}
+
+static void keepsTheDiscoveryPassConsistent()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	bus.oneWire.addSensor(2, 21);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasThresholdsN<ONE_WIRE_MAX_DEV> thresholds;
+	sensors.attachThresholds(&thresholds);
+	sensors.begin(NonBlockingDallas::resolution_12, 5000);
+	sensors.setDiscovery(1, 0); // Passes paused between update() calls, one after the other
+	sensors.setAlarmMode(4);
+	runFor(sensors, 1500);
+
+	// Thresholds changed while a discovery pass is paused mid-ROM
+	bus.oneWire.resetCounters();
+	for (uint8_t n = 0; n < 30; n++)
+	{
+		sensors.setThresholds(n & 1, celsiusToRAW(-(n % 20)), celsiusToRAW(30 + n % 20));
+		runFor(sensors, 100);
+	}
+	CHECK_EQUAL(0, bus.oneWire.protocolErrors);
+	CHECK_EQUAL(2, sensors.getSensorsCount());
+	CHECK(sensors.isSensorPresent(0));
+	CHECK(sensors.isSensorPresent(1));
+}
+
+int main()
+{
+	RUN_TEST(programsTheAlarmRegisters);
+	RUN_TEST(readsOnlyTheAlarmedSensors);
+	RUN_TEST(keepsTheDiscoveryPassConsistent);
+	return hostResult();
+}
@@ -0,0 +1,65 @@
+#include <HostTest.h>
+
+static void startsFromTheCache()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	bus.oneWire.addSensor(2, -3.5f);
+	uint8_t cache[NonBlockingDallas::getCacheSize(ONE_WIRE_MAX_DEV)];
+	size_t cacheSize;
+	{
+		NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+		sensors.begin(NonBlockingDallas::resolution_12, 1000);
+		cacheSize = sensors.exportCache(cache, sizeof(cache));
+		CHECK_EQUAL(NonBlockingDallas::getCacheSize(2), cacheSize);
+	}
+
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	bus.oneWire.resetCounters();
+	CHECK(sensors.beginFromCache(cache, cacheSize, NonBlockingDallas::resolution_12, 1000));
+	CHECK_EQUAL(2, sensors.getSensorsCount());
+	runFor(sensors, 1500);
+	CHECK_EQUAL(celsiusToRAW(20), sensors.getTemperatureRAW(sensors.getIndex(bus.oneWire.sensor(0).rom)));
+	CHECK_EQUAL(celsiusToRAW(-3.5f), sensors.getTemperatureRAW(sensors.getIndex(bus.oneWire.sensor(1).rom)));
+}
+
+static void rejectsACorruptedCache()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	uint8_t cache[NonBlockingDallas::getCacheSize(1)];
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	CHECK_EQUAL(sizeof(cache), sensors.exportCache(cache, sizeof(cache)));
+
+	cache[5] ^= 1;
+	CHECK(!sensors.beginFromCache(cache, sizeof(cache), NonBlockingDallas::resolution_12, 1000));
+	CHECK_EQUAL(1, sensors.getSensorsCount()); // Found by begin()
+}
+
+static void sweepsAtTheValidatedInterval()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	uint8_t cache[NonBlockingDallas::getCacheSize(1)];
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	sensors.exportCache(cache, sizeof(cache));
+
+	// Shorter than the conversion, DEFAULT_INTERVAL used: one sweep at once, the next one after the interval
+	CHECK(sensors.beginFromCache(cache, sizeof(cache), NonBlockingDallas::resolution_12, 10));
+	runFor(sensors, 1500);
+	bus.oneWire.addSensor(2, 25);
+	runFor(sensors, DEFAULT_INTERVAL / 2);
+	CHECK_EQUAL(1, sensors.getSensorsCount());
+	runFor(sensors, DEFAULT_INTERVAL);
+	CHECK_EQUAL(2, sensors.getSensorsCount());
+}
+
+int main()
+{
+	RUN_TEST(startsFromTheCache);
+	RUN_TEST(rejectsACorruptedCache);
+	RUN_TEST(sweepsAtTheValidatedInterval);
+	return hostResult();
+}
@@ -0,0 +1,121 @@
+#include <HostTest.h>
+#include <math.h>
+
+struct conversion
+{
+	int32_t raw;
+	int32_t centiCelsius;
+	int32_t centiFahrenheit;
+	int32_t celsiusQ8;
+	int32_t fahrenheitQ8;
+};
+
+// Hundredths are rounded half up, 1/256 °F half away from zero, 1/256 °C is exact
+static const conversion conversions[] = {
+	{0, 0, 3200, 0, 8192},
+	{1, 1, 3201, 2, 8196},
+	{-1, -1, 3199, -2, 8188},
+	{3, 2, 3204, 6, 8203},
+	{5, 4, 3207, 10, 8210},
+	{8, 6, 3211, 16, 8221},		 // 1/16 °C
+	{-8, -6, 3189, -16, 8163},
+	{16, 13, 3223, 32, 8250},	 // 12.5 and 22.5 hundredths
+	{-16, -12, 3178, -32, 8134}, // -12.5 and -22.5 hundredths
+	{48, 38, 3268, 96, 8365},	 // 37.5 hundredths
+	{-48, -37, 3133, -96, 8019},
+	{-1288, -1006, 1389, -2576, 3555}, // -10.0625 °C
+	{2560, 2000, 6800, 5120, 17408},   // 20 °C
+	{16000, 12500, 25700, 32000, 65792}, // 125 °C, top of the range
+	{DEVICE_DISCONNECTED_RAW, -5500, -6700, -14080, -17152}, // Converted as any value: -55 °C, bottom of the range
+};
+
+static const uint8_t conversionsCount = sizeof(conversions) / sizeof(conversions[0]);
+
+static void convertsTheTable()
+{
+	for (uint8_t i = 0; i < conversionsCount; i++)
+	{
+		const conversion &c = conversions[i];
+		CHECK_EQUAL(c.centiCelsius, NonBlockingDallas::rawToCentiCelsius(c.raw));
+		CHECK_EQUAL(c.centiFahrenheit, NonBlockingDallas::rawToCentiFahrenheit(c.raw));
+		CHECK_EQUAL(c.celsiusQ8, NonBlockingDallas::rawToCelsiusQ8(c.raw));
+		CHECK_EQUAL(c.fahrenheitQ8, NonBlockingDallas::rawToFahrenheitQ8(c.raw));
+	}
+}
+
+static void convertsArraysInPlace()
+{
+	const NonBlockingDallas::integerUnit units[] = {NonBlockingDallas::centiCelsius, NonBlockingDallas::centiFahrenheit,
+													NonBlockingDallas::celsiusQ8, NonBlockingDallas::fahrenheitQ8};
+	for (uint8_t u = 0; u < 4; u++)
+	{
+		int32_t values[conversionsCount];
+		for (uint8_t i = 0; i < conversionsCount; i++)
+			values[i] = conversions[i].raw;
+		NonBlockingDallas::convertRAW(values, values, conversionsCount, units[u]);
+		for (uint8_t i = 0; i < conversionsCount; i++)
+		{
+			const conversion &c = conversions[i];
+			const int32_t expected[] = {c.centiCelsius, c.centiFahrenheit, c.celsiusQ8, c.fahrenheitQ8};
+			CHECK_EQUAL(expected[u], values[i]);
+		}
+	}
+}
+
+static void convertsTheReadings()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, -10.0625f);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+	uint8_t index = sensors.getIndex(sensor.rom);
+	char addressString[17];
+	NonBlockingDallas::formatAddress(sensor.rom, addressString);
+
+	CHECK_EQUAL(-1006, sensors.getTemperatureCentiC(index));
+	CHECK_EQUAL(1389, sensors.getTemperatureCentiF(index));
+	CHECK_EQUAL(-2576, sensors.getTemperatureQ8C(index));
+	CHECK_EQUAL(3555, sensors.getTemperatureQ8F(index));
+	CHECK_EQUAL(-1288, sensors.getTemperatureRAW(sensor.rom));
+	CHECK_EQUAL(-1288, sensors.getTemperatureRAW(addressString));
+	CHECK(fabsf(sensors.getTemperatureC(sensor.rom) + 10.0625f) < 0.001f);
+	CHECK(fabsf(sensors.getTemperatureF(sensor.rom) - 13.8875f) < 0.001f);
+	CHECK(fabsf(sensors.getTemperatureC(addressString) + 10.0625f) < 0.001f);
+	CHECK(fabsf(sensors.getTemperatureF(addressString) - 13.8875f) < 0.001f);
+
+	int32_t centi[1];
+	CHECK_EQUAL(1, sensors.getTemperatures(centi, 1, NonBlockingDallas::centiFahrenheit));
+	CHECK_EQUAL(1389, centi[0]);
+}
+
+static void reportsUnknownSensors()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+
+	CHECK_EQUAL(DEVICE_DISCONNECTED_C * 100, sensors.getTemperatureCentiC(5));
+	CHECK_EQUAL((int32_t)(DEVICE_DISCONNECTED_F * 100), sensors.getTemperatureCentiF(5));
+	CHECK_EQUAL(DEVICE_DISCONNECTED_C * 256, sensors.getTemperatureQ8C(5));
+	CHECK_EQUAL((int32_t)(DEVICE_DISCONNECTED_F * 256), sensors.getTemperatureQ8F(5));
+
+	const DeviceAddress unknown = {0x28, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+	CHECK_EQUAL(DEVICE_DISCONNECTED_RAW, sensors.getTemperatureRAW(unknown));
+	CHECK(sensors.getTemperatureC(unknown) == DEVICE_DISCONNECTED_C);
+	CHECK(sensors.getTemperatureF(unknown) == (float)DEVICE_DISCONNECTED_F);
+	CHECK_EQUAL(DEVICE_DISCONNECTED_RAW, sensors.getTemperatureRAW("2801020304050607"));
+	CHECK(sensors.getTemperatureC("2801020304050607") == DEVICE_DISCONNECTED_C);
+	CHECK(sensors.getTemperatureF("2801020304050607") == (float)DEVICE_DISCONNECTED_F);
+}
+
+int main()
+{
+	RUN_TEST(convertsTheTable);
+	RUN_TEST(convertsArraysInPlace);
+	RUN_TEST(convertsTheReadings);
+	RUN_TEST(reportsUnknownSensors);
+	return hostResult();
+}
@@ -0,0 +1,104 @@
+#include <HostTest.h>
+
+static void addsPluggedSensors()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.setDiscovery(8, 2000);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	CHECK_EQUAL(1, sensors.getSensorsCount());
+	runFor(sensors, 1500);
+
+	SimulatedSensor &plugged = bus.oneWire.addSensor(2, 35);
+	runFor(sensors, 6000);
+	CHECK_EQUAL(2, sensors.getSensorsCount());
+	CHECK_EQUAL(1, sensors.getIndex(plugged.rom)); // Appended, the known sensor keeps its index
+	CHECK_EQUAL(0, sensors.getIndex(bus.oneWire.sensor(0).rom));
+	CHECK_EQUAL(celsiusToRAW(35), sensors.getTemperatureRAW((uint8_t)1));
+}
+
+static void marksMissingSensors()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	SimulatedSensor &unplugged = bus.oneWire.addSensor(2, 25);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.setDiscovery(8, 2000);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+	int8_t index = sensors.getIndex(unplugged.rom);
+	CHECK(sensors.isSensorPresent(index));
+
+	unplugged.present = false;
+	runFor(sensors, 6000);
+	CHECK(!sensors.isSensorPresent(index));
+	CHECK_EQUAL(2, sensors.getSensorsCount());
+
+	unplugged.present = true;
+	runFor(sensors, 6000);
+	CHECK(sensors.isSensorPresent(index));
+}
+
+static void startsOnAnEmptyBus()
+{
+	HostBus bus;
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.setDiscovery(8, 1000);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	CHECK_EQUAL(0, sensors.getSensorsCount());
+
+	bus.oneWire.addSensor(7, 5);
+	runFor(sensors, 5000);
+	CHECK_EQUAL(1, sensors.getSensorsCount());
+	CHECK_EQUAL(celsiusToRAW(5), sensors.getTemperatureRAW((uint8_t)0));
+}
+
+static void sweepsAtTheValidatedInterval()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 10); // Shorter than the conversion, DEFAULT_INTERVAL used
+	runFor(sensors, 1500);
+
+	bus.oneWire.addSensor(2, 25);
+	runFor(sensors, DEFAULT_INTERVAL / 2);
+	CHECK_EQUAL(1, sensors.getSensorsCount());
+	runFor(sensors, DEFAULT_INTERVAL);
+	CHECK_EQUAL(2, sensors.getSensorsCount());
+}
+
+static void keepsTheIntervalSetBeforeBegin()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.setDiscovery(8, 1000);
+	sensors.begin(NonBlockingDallas::resolution_12, 20000);
+	runFor(sensors, 1500);
+
+	bus.oneWire.addSensor(2, 25);
+	runFor(sensors, 3000); // Far shorter than the interval of begin()
+	CHECK_EQUAL(2, sensors.getSensorsCount());
+
+	uint8_t cache[NonBlockingDallas::getCacheSize(2)];
+	CHECK_EQUAL(sizeof(cache), sensors.exportCache(cache, sizeof(cache)));
+	NonBlockingDallas cached(&bus.dallasTemp, &bus.oneWire);
+	cached.setDiscovery(8, 1000);
+	CHECK(cached.beginFromCache(cache, sizeof(cache), NonBlockingDallas::resolution_12, 20000));
+	runFor(cached, 1500);
+	bus.oneWire.addSensor(3, 30);
+	runFor(cached, 3000);
+	CHECK_EQUAL(3, cached.getSensorsCount());
+}
+
+int main()
+{
+	RUN_TEST(addsPluggedSensors);
+	RUN_TEST(marksMissingSensors);
+	RUN_TEST(startsOnAnEmptyBus);
+	RUN_TEST(sweepsAtTheValidatedInterval);
+	RUN_TEST(keepsTheIntervalSetBeforeBegin);
+	return hostResult();
+}
@@ -0,0 +1,119 @@
+#include <HostTest.h>
+#include <NonBlockingDallasEventQueue.h>
+#include <atomic>
+#include <thread>
+
+typedef NonBlockingDallasEventQueue::event event;
+
+static void keepsTheOrderAndDrops()
+{
+	NonBlockingDallasEventQueueN<3> queue;
+	event e;
+	CHECK(!queue.pop(e));
+	for (int32_t i = 1; i <= 4; i++)
+		queue.push(NonBlockingDallasEventQueue::intervalElapsed, 0, i);
+	CHECK_EQUAL(3, queue.getCount());
+	CHECK_EQUAL(3, queue.getHighWater());
+	CHECK_EQUAL(1, queue.getDropped());
+	for (int32_t i = 2; i <= 4; i++)
+	{
+		CHECK(queue.pop(e));
+		CHECK_EQUAL(i, e.temperatureRAW);
+	}
+	CHECK(!queue.pop(e));
+
+	queue.setOverflowPolicy(NonBlockingDallasEventQueue::dropNewest);
+	for (int32_t i = 5; i <= 8; i++)
+		queue.push(NonBlockingDallasEventQueue::temperatureChange, 0, i);
+	CHECK(queue.pop(e));
+	CHECK_EQUAL(5, e.temperatureRAW);
+	queue.clear();
+	CHECK_EQUAL(0, queue.getCount());
+	CHECK(!queue.pop(e));
+}
+
+static void defersTheCallbacks()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	NonBlockingDallasEventQueueN<8> queue;
+	sensors.attachEventQueue(&queue);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 3500);
+	CHECK_EQUAL(4, queue.getCount()); // One interval per second and the first change, not dispatched yet
+	CHECK_EQUAL(4, sensors.dispatch());
+	CHECK_EQUAL(0, queue.getCount());
+}
+
+// Each event carries its sequence number in all its fields, a torn copy shows up at once
+static void passesEventsBetweenThreads(NonBlockingDallasEventQueue::overflowPolicy policy)
+{
+	const uint32_t events = 200000;
+	NonBlockingDallasEventQueueN<16> queue;
+	queue.setOverflowPolicy(policy);
+	std::atomic<bool> done(false);
+	uint32_t received = 0;
+	uint32_t torn = 0;
+	uint32_t unordered = 0;
+
+	std::thread consumer([&]() {
+		int32_t last = 0;
+		event e;
+		for (;;)
+		{
+			bool finished = done;
+			if (!queue.pop(e))
+			{
+				if (finished)
+					break;
+				std::this_thread::yield();
+				continue;
+			}
+			received++;
+			if (e.deviceIndex != (uint16_t)e.temperatureRAW || e.type != (uint8_t)(e.temperatureRAW % 3))
+				torn++;
+			if (e.temperatureRAW <= last)
+				unordered++;
+			last = e.temperatureRAW;
+		}
+	});
+
+	for (int32_t i = 1; i <= (int32_t)events; i++)
+	{
+		// With dropNewest the producer waits for room, so that no event is lost
+		while (!queue.push(i % 3, (uint16_t)i, i) && policy == NonBlockingDallasEventQueue::dropNewest)
+			std::this_thread::yield();
+	}
+	done = true;
+	consumer.join();
+
+	CHECK_EQUAL(0, torn);
+	CHECK_EQUAL(0, unordered);
+	if (policy == NonBlockingDallasEventQueue::dropNewest)
+		CHECK_EQUAL(events, received);
+	else
+	{
+		CHECK(received <= events);
+		CHECK(received + queue.getDropped() >= events); // An event popped while overwritten may count as dropped
+	}
+}
+
+static void passesEventsBetweenThreadsDroppingTheNewest()
+{
+	passesEventsBetweenThreads(NonBlockingDallasEventQueue::dropNewest);
+}
+
+static void passesEventsBetweenThreadsDroppingTheOldest()
+{
+	passesEventsBetweenThreads(NonBlockingDallasEventQueue::dropOldest);
+}
+
+int main()
+{
+	RUN_TEST(keepsTheOrderAndDrops);
+	RUN_TEST(defersTheCallbacks);
+	RUN_TEST(passesEventsBetweenThreadsDroppingTheNewest);
+	RUN_TEST(passesEventsBetweenThreadsDroppingTheOldest);
+	return hostResult();
+}
@@ -0,0 +1,101 @@
+#include <HostTest.h>
+
+// One event per readout: 'r' for a reading, 'd' for a disconnection
+static char events[64];
+static uint8_t eventsCount;
+
+static void handleIntervalElapsed(int, int32_t)
+{
+	if (eventsCount < 64)
+		events[eventsCount++] = 'r';
+}
+
+static void handleDeviceDisconnected(int)
+{
+	if (eventsCount < 64)
+		events[eventsCount++] = 'd';
+}
+
+static void start(NonBlockingDallasBase &sensors)
+{
+	eventsCount = 0;
+	sensors.onIntervalElapsed(handleIntervalElapsed);
+	sensors.onDeviceDisconnected(handleDeviceDisconnected);
+	sensors.setDiscovery(0, 0); // Missing sensors stay in the table
+}
+
+// A flipped bit passes the fast read, only the CRC checked readouts catch it
+static void checksOneReadoutEveryCycles()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	start(sensors);
+	CHECK(sensors.setFastRead(4));
+	sensor.corruptReads = 0xFFFF;
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 12500);
+
+	CHECK(eventsCount >= 12);
+	for (uint8_t i = 0; i < eventsCount; i++)
+	{
+		char expected = (i + 1) % 4 == 0 ? 'd' : 'r';
+		if (events[i] != expected)
+			printf("readout %u: '%c', expected '%c'\n", i, events[i], expected);
+		CHECK(events[i] == expected);
+	}
+}
+
+static void readsAnIdleBusInFull()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	SimulatedSensor &missing = bus.oneWire.addSensor(2, 25);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+	uint8_t index = sensors.getIndex(missing.rom);
+	CHECK_EQUAL(celsiusToRAW(25), sensors.getTemperatureRAW(index));
+
+	// The other sensor answers the reset, the missing one leaves the bus high: 0xFFFF is -1/16 °C
+	start(sensors);
+	sensors.onIntervalElapsed(NULL); // The readings of the other sensor
+	sensors.setFastRead(100);
+	missing.present = false;
+	runFor(sensors, 8000);
+	CHECK(eventsCount >= 7);
+	for (uint8_t i = 0; i < eventsCount; i++)
+		CHECK(events[i] == 'd');
+	CHECK(sensors.getTemperatureRAW(index) != celsiusToRAW(-0.0625f));
+}
+
+static void readsADisconnectedSensorInFull()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+
+	// Nothing answers the reset, the fast read gives up before reading
+	start(sensors);
+	sensors.setFastRead(100);
+	sensor.present = false;
+	runFor(sensors, 8000);
+	CHECK(eventsCount >= 7);
+	for (uint8_t i = 0; i < eventsCount; i++)
+		CHECK(events[i] == 'd');
+	CHECK(sensors.getTemperatureRAW((uint8_t)0) != celsiusToRAW(-0.0625f));
+
+	sensor.present = true;
+	runFor(sensors, 2000);
+	CHECK_EQUAL(celsiusToRAW(20), sensors.getTemperatureRAW((uint8_t)0));
+}
+
+int main()
+{
+	RUN_TEST(checksOneReadoutEveryCycles);
+	RUN_TEST(readsAnIdleBusInFull);
+	RUN_TEST(readsADisconnectedSensorInFull);
+	return hostResult();
+}
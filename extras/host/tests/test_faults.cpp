@@ -0,0 +1,115 @@
+#include <HostTest.h>
+#include <NonBlockingDallasStats.h>
+
+static int disconnectedCalls;
+
+static void handleDeviceDisconnected(int)
+{
+	disconnectedCalls++;
+}
+
+static void countsCorruptedReadings()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	SimulatedSensor &noisy = bus.oneWire.addSensor(2, 30);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	NonBlockingDallasStatsN<ONE_WIRE_MAX_DEV> counters;
+	sensors.attachStats(&counters);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+	int8_t index = sensors.getIndex(noisy.rom);
+	CHECK_EQUAL(celsiusToRAW(30), sensors.getTemperatureRAW(index));
+
+	noisy.setCelsius(31);
+	noisy.corruptReads = 1;
+	runFor(sensors, 1000);
+	NonBlockingDallasStats::sensorStats stats;
+	CHECK(counters.getSensorStats(index, stats));
+	CHECK_EQUAL(1, stats.crcErrors);
+	CHECK_EQUAL(0, stats.disconnects);
+	CHECK_EQUAL(celsiusToRAW(30), sensors.getTemperatureRAW(index)); // Corrupted reading dropped
+
+	runFor(sensors, 1000);
+	CHECK_EQUAL(celsiusToRAW(31), sensors.getTemperatureRAW(index));
+}
+
+static void reportsDisconnectedSensors()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	bus.oneWire.addSensor(2, 25);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	NonBlockingDallasStatsN<ONE_WIRE_MAX_DEV> counters;
+	sensors.attachStats(&counters);
+	sensors.onDeviceDisconnected(handleDeviceDisconnected);
+	disconnectedCalls = 0;
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+
+	sensor.present = false;
+	runFor(sensors, 2000);
+	CHECK(disconnectedCalls >= 1);
+	NonBlockingDallasStats::sensorStats stats;
+	CHECK(counters.getSensorStats(sensors.getIndex(sensor.rom), stats));
+	CHECK(stats.disconnects >= 1);
+	CHECK_EQUAL(0, stats.crcErrors);
+
+	sensor.present = true;
+	sensor.setCelsius(22);
+	runFor(sensors, 2000);
+	CHECK_EQUAL(celsiusToRAW(22), sensors.getTemperatureRAW(sensors.getIndex(sensor.rom)));
+}
+
+static void waitsForSlowConversions()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	sensor.extraConversionMicros = 200000;
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	NonBlockingDallasStatsN<ONE_WIRE_MAX_DEV> counters;
+	sensors.attachStats(&counters);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+	CHECK_EQUAL(celsiusToRAW(20), sensors.getTemperatureRAW((uint8_t)0)); // Not the 85 °C of the power-on
+	NonBlockingDallasStats::sensorStats stats;
+	CHECK(counters.getSensorStats(0, stats));
+	CHECK_EQUAL(0, stats.crcErrors + stats.disconnects);
+	CHECK(stats.conversionMillis >= 950); // The measured time, not the 750 ms estimate of 12 bits
+}
+
+static void survivesAShortedBus()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	bus.oneWire.shorted = true;
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	CHECK_EQUAL(0, sensors.getSensorsCount());
+	runFor(sensors, 2000);
+	CHECK_EQUAL(0, sensors.getSensorsCount());
+}
+
+static void recoversFromAPowerOnReset()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+
+	// A brown-out leaves 85 °C in the register until the next conversion
+	sensor.powerOnReset();
+	runFor(sensors, 3000);
+	CHECK_EQUAL(celsiusToRAW(20), sensors.getTemperatureRAW((uint8_t)0));
+}
+
+int main()
+{
+	RUN_TEST(countsCorruptedReadings);
+	RUN_TEST(reportsDisconnectedSensors);
+	RUN_TEST(waitsForSlowConversions);
+	RUN_TEST(survivesAShortedBus);
+	RUN_TEST(recoversFromAPowerOnReset);
+	return hostResult();
+}
@@ -0,0 +1,146 @@
+#include <HostTest.h>
+#include <NonBlockingDallasChangeFilter.h>
+
+static int32_t changes[32];
+static unsigned long changeMillis[32];
+static uint8_t changesCount;
+
+static void handleTemperatureChange(int, int32_t temperatureRAW)
+{
+	if (changesCount < 32)
+	{
+		changes[changesCount] = temperatureRAW;
+		changeMillis[changesCount] = millis();
+		changesCount++;
+	}
+}
+
+// One reading per second, each step of the loops below holds one reading
+static void start(NonBlockingDallasBase &sensors)
+{
+	changesCount = 0;
+	sensors.onTemperatureChange(handleTemperatureChange);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1000);
+}
+
+static void reportsAnyChangeWithoutAFilter()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	CHECK(!sensors.setChangeFilter(0, 32, 16)); // Nothing to keep the deadband in
+	start(sensors);
+	CHECK_EQUAL(1, changesCount);
+
+	runFor(sensors, 2000);
+	CHECK_EQUAL(1, changesCount);
+	sensor.setCelsius(20.0625f);
+	runFor(sensors, 1000);
+	CHECK_EQUAL(2, changesCount);
+	CHECK_EQUAL(celsiusToRAW(20.0625f), changes[1]);
+}
+
+static void reportsTheFirstReading()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasChangeFilterN<ONE_WIRE_MAX_DEV> changeFilter;
+	sensors.attachChangeFilter(&changeFilter);
+	sensors.setChangeFilterAll(1000, 1000);
+	start(sensors);
+	CHECK_EQUAL(1, changesCount);
+	CHECK_EQUAL(celsiusToRAW(20), changes[0]);
+}
+
+static void suppressesMovesInsideTheDeadband()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasChangeFilterN<ONE_WIRE_MAX_DEV> changeFilter;
+	sensors.attachChangeFilter(&changeFilter);
+	start(sensors);
+	CHECK(sensors.setChangeFilter(0, 32, 16));
+
+	const float moves[] = {20.125f, 20.25f, 19.875f, 19.75f}; // Within 32 RAW of the reported 20 °C
+	for (uint8_t n = 0; n < 4; n++)
+	{
+		sensor.setCelsius(moves[n]);
+		runFor(sensors, 1000);
+	}
+	CHECK_EQUAL(1, changesCount);
+
+	sensor.setCelsius(20.3125f);
+	runFor(sensors, 1000);
+	CHECK_EQUAL(2, changesCount);
+	CHECK_EQUAL(celsiusToRAW(20.3125f), changes[1]);
+}
+
+static void needsTheHysteresisToReverse()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasChangeFilterN<ONE_WIRE_MAX_DEV> changeFilter;
+	sensors.attachChangeFilter(&changeFilter);
+	start(sensors);
+	sensors.setChangeFilter(0, 32, 16);
+
+	sensor.setCelsius(20.5f); // Up by 64 RAW, reported
+	runFor(sensors, 1000);
+	CHECK_EQUAL(2, changesCount);
+
+	// Down by 40 and 48 RAW: beyond the deadband, within deadband + hysteresis
+	sensor.setCelsius(20.1875f);
+	runFor(sensors, 1000);
+	sensor.setCelsius(20.125f);
+	runFor(sensors, 1000);
+	CHECK_EQUAL(2, changesCount);
+
+	sensor.setCelsius(20.0625f); // Down by 56 RAW
+	runFor(sensors, 1000);
+	CHECK_EQUAL(3, changesCount);
+	CHECK_EQUAL(celsiusToRAW(20.0625f), changes[2]);
+
+	sensor.setCelsius(19.75f); // Same direction, the deadband alone applies: down by 40 RAW
+	runFor(sensors, 1000);
+	CHECK_EQUAL(4, changesCount);
+}
+
+static void throttlesByTheMinimumInterval()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasChangeFilterN<ONE_WIRE_MAX_DEV> changeFilter;
+	sensors.attachChangeFilter(&changeFilter);
+	sensors.setMinChangeInterval(5000);
+	start(sensors);
+
+	// A change at every reading, reported at most once every 5 s
+	for (uint8_t n = 1; n <= 12; n++)
+	{
+		sensor.setCelsius(20 + n);
+		runFor(sensors, 1000);
+	}
+	// Each report is the first reading after the interval, with its own temperature
+	CHECK_EQUAL(3, changesCount);
+	for (uint8_t i = 1; i < changesCount; i++)
+	{
+		CHECK(changeMillis[i] - changeMillis[i - 1] >= 5000);
+		CHECK(changeMillis[i] - changeMillis[i - 1] < 6000);
+		CHECK(changes[i] >= changes[i - 1] + celsiusToRAW(5));
+	}
+}
+
+int main()
+{
+	RUN_TEST(reportsAnyChangeWithoutAFilter);
+	RUN_TEST(reportsTheFirstReading);
+	RUN_TEST(suppressesMovesInsideTheDeadband);
+	RUN_TEST(needsTheHysteresisToReverse);
+	RUN_TEST(throttlesByTheMinimumInterval);
+	return hostResult();
+}
@@ -0,0 +1,31 @@
+#include <HostTest.h>
+#include <NonBlockingDallasHistory.h>
+
+static void keepsTheLastReadings()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	NonBlockingDallasHistoryN<ONE_WIRE_MAX_DEV, 4> history;
+	sensors.attachHistory(&history);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+
+	static const float readings[] = {20, 22, 19, 25, 21, 23};
+	for (float celsius : readings)
+	{
+		sensor.setCelsius(celsius);
+		runFor(sensors, 1000);
+	}
+	CHECK_EQUAL(4, history.getSampleCount(0));
+	CHECK_EQUAL(celsiusToRAW(23), history.getSample(0, 0));
+	CHECK_EQUAL(celsiusToRAW(19), history.getSample(0, 3));
+	CHECK_EQUAL(celsiusToRAW(19), history.getMin(0));
+	CHECK_EQUAL(celsiusToRAW(25), history.getMax(0));
+	CHECK_EQUAL(celsiusToRAW(22), history.getMean(0));
+}
+
+int main()
+{
+	RUN_TEST(keepsTheLastReadings);
+	return hostResult();
+}
@@ -0,0 +1,70 @@
+#include <HostTest.h>
+#include <NonBlockingDallasManager.h>
+
+static int8_t lastIndex;
+static int32_t lastRAW;
+
+static void handleIntervalElapsed(int deviceIndex, int32_t temperatureRAW)
+{
+	if (temperatureRAW == celsiusToRAW(40))
+	{
+		lastIndex = deviceIndex;
+		lastRAW = temperatureRAW;
+	}
+}
+
+static void givesEachBusAFixedRange()
+{
+	HostBus busA, busB;
+	busA.oneWire.addSensor(1, 20);
+	SimulatedSensor &sensorB = busB.oneWire.addSensor(2, 40);
+	NonBlockingDallasN<4> sensorsA(&busA.dallasTemp, &busA.oneWire);
+	NonBlockingDallas sensorsB(&busB.dallasTemp, &busB.oneWire);
+	NonBlockingDallasManager manager;
+	CHECK(manager.addBus(&sensorsA));
+	CHECK(manager.addBus(&sensorsB));
+	CHECK_EQUAL(4 + ONE_WIRE_MAX_DEV, manager.getCapacity());
+	manager.onIntervalElapsed(handleIntervalElapsed);
+	lastIndex = -1;
+	manager.begin(NonBlockingDallas::resolution_12, 1000);
+	sensorsA.setDiscovery(8, 1000);
+
+	CHECK_EQUAL(2, manager.getSensorsCount());
+	CHECK_EQUAL(4, manager.getIndex(sensorB.rom));
+	CHECK(!manager.indexExist(1));
+	CHECK(manager.indexExist(4));
+	runFor(manager, 2000);
+	CHECK_EQUAL(4, lastIndex);
+	CHECK_EQUAL(celsiusToRAW(40), manager.getTemperatureRAW((uint8_t)4));
+
+	// A sensor discovered on the first bus takes its next index, the second bus keeps its range
+	SimulatedSensor &plugged = busA.oneWire.addSensor(3, 30);
+	runFor(manager, 5000);
+	CHECK_EQUAL(3, manager.getSensorsCount());
+	CHECK_EQUAL(1, manager.getIndex(plugged.rom));
+	CHECK_EQUAL(4, manager.getIndex(sensorB.rom));
+	CHECK_EQUAL(celsiusToRAW(30), manager.getTemperatureRAW((uint8_t)1));
+	CHECK_EQUAL(celsiusToRAW(40), manager.getTemperatureRAW((uint8_t)4));
+	CHECK_EQUAL(4, lastIndex);
+}
+
+static void limitsTheIndexSpace()
+{
+	HostBus bus;
+	NonBlockingDallasN<100> large(&bus.dallasTemp);
+	NonBlockingDallasN<27> medium(&bus.dallasTemp);
+	NonBlockingDallasN<1> small(&bus.dallasTemp);
+	NonBlockingDallasManager manager;
+	CHECK(manager.addBus(&large));
+	CHECK(manager.addBus(&medium));
+	CHECK(!manager.addBus(&small)); // 128 indexes, getIndex() returns int8_t
+	CHECK_EQUAL(2, manager.getBusCount());
+	CHECK_EQUAL(127, manager.getCapacity());
+}
+
+int main()
+{
+	RUN_TEST(givesEachBusAFixedRange);
+	RUN_TEST(limitsTheIndexSpace);
+	return hostResult();
+}
@@ -0,0 +1,110 @@
+#include <HostTest.h>
+
+static char firstString[17];
+static char secondString[17];
+
+static void resolvesBothForms()
+{
+	HostBus bus;
+	SimulatedSensor &first = bus.oneWire.addSensor(1, 20);
+	SimulatedSensor &second = bus.oneWire.addSensor(2, -5.5f);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+
+	// Listed in the reverse order of the bus
+	DeviceAddress addresses[2];
+	memcpy(addresses[0], second.rom, 8);
+	memcpy(addresses[1], first.rom, 8);
+	NonBlockingDallasQueryN<2> query;
+	CHECK(query.setAddresses(addresses, 2));
+	CHECK_EQUAL(2, query.getCount());
+	int32_t values[2];
+	CHECK_EQUAL(2, sensors.getTemperaturesRAW(query, values));
+	CHECK_EQUAL(celsiusToRAW(-5.5f), values[0]);
+	CHECK_EQUAL(celsiusToRAW(20), values[1]);
+
+	NonBlockingDallas::formatAddress(first.rom, firstString);
+	NonBlockingDallas::formatAddress(second.rom, secondString);
+	const char *const strings[] = {firstString, secondString};
+	CHECK(query.setAddresses(strings, 2));
+	CHECK_EQUAL(2, sensors.getTemperaturesRAW(query, values));
+	CHECK_EQUAL(celsiusToRAW(20), values[0]);
+	CHECK_EQUAL(celsiusToRAW(-5.5f), values[1]);
+}
+
+static void keepsTheQueryOnFailure()
+{
+	HostBus bus;
+	SimulatedSensor &first = bus.oneWire.addSensor(1, 20);
+	SimulatedSensor &second = bus.oneWire.addSensor(2, 30);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+
+	NonBlockingDallas::formatAddress(first.rom, firstString);
+	NonBlockingDallas::formatAddress(second.rom, secondString);
+	const char *const strings[] = {firstString, secondString};
+	NonBlockingDallasQueryN<2> query;
+	CHECK(query.setAddresses(strings, 2));
+
+	// The first string is valid, the second is not: nothing is overwritten
+	const char *const invalid[] = {secondString, "28ff641e0f1b2cXX"};
+	CHECK(!query.setAddresses(invalid, 2));
+	const char *const tooMany[] = {secondString, firstString, secondString};
+	CHECK(!query.setAddresses(tooMany, 3));
+	DeviceAddress addresses[3];
+	memcpy(addresses[0], second.rom, 8);
+	memcpy(addresses[1], first.rom, 8);
+	memcpy(addresses[2], second.rom, 8);
+	CHECK(!query.setAddresses(addresses, 3));
+
+	CHECK_EQUAL(2, query.getCount());
+	int32_t values[2];
+	CHECK_EQUAL(2, sensors.getTemperaturesRAW(query, values));
+	CHECK_EQUAL(celsiusToRAW(20), values[0]);
+	CHECK_EQUAL(celsiusToRAW(30), values[1]);
+}
+
+static void resolvesAgainWhenTheTableChanges()
+{
+	HostBus bus;
+	SimulatedSensor &first = bus.oneWire.addSensor(1, 20);
+	SimulatedSensor &plugged = bus.oneWire.addSensor(2, 35);
+	plugged.present = false;
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.setDiscovery(8, 2000);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+
+	DeviceAddress addresses[2];
+	memcpy(addresses[0], plugged.rom, 8);
+	memcpy(addresses[1], first.rom, 8);
+	NonBlockingDallasQueryN<2> query;
+	query.setAddresses(addresses, 2);
+	int32_t values[2];
+	CHECK_EQUAL(1, sensors.getTemperaturesRAW(query, values));
+	CHECK_EQUAL(DEVICE_DISCONNECTED_RAW, values[0]);
+	uint16_t generation = sensors.getTableGeneration();
+
+	plugged.present = true;
+	runFor(sensors, 6000);
+	CHECK(sensors.getTableGeneration() != generation);
+	CHECK_EQUAL(2, sensors.getTemperaturesRAW(query, values));
+	CHECK_EQUAL(celsiusToRAW(35), values[0]);
+	CHECK_EQUAL(celsiusToRAW(20), values[1]);
+
+	// New addresses are resolved again even though the table did not change
+	memcpy(addresses[1], plugged.rom, 8);
+	query.setAddresses(addresses, 2);
+	CHECK_EQUAL(2, sensors.getTemperaturesRAW(query, values));
+	CHECK_EQUAL(celsiusToRAW(35), values[1]);
+}
+
+int main()
+{
+	RUN_TEST(resolvesBothForms);
+	RUN_TEST(keepsTheQueryOnFailure);
+	RUN_TEST(resolvesAgainWhenTheTableChanges);
+	return hostResult();
+}
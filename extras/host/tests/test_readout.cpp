@@ -0,0 +1,231 @@
+#include <HostTest.h>
+#include <NonBlockingDallasTimings.h>
+
+static int intervalCalls;
+static int32_t lastRAW[3];
+
+static void handleIntervalElapsed(int deviceIndex, int32_t temperatureRAW)
+{
+	intervalCalls++;
+	if (deviceIndex >= 0 && deviceIndex < 3)
+		lastRAW[deviceIndex] = temperatureRAW;
+}
+
+static void readsAllSensors()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 21.5f);
+	bus.oneWire.addSensor(2, -10.25f);
+	bus.oneWire.addSensor(3, 0);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	sensors.onIntervalElapsed(handleIntervalElapsed);
+	intervalCalls = 0;
+
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	CHECK_EQUAL(3, sensors.getSensorsCount());
+	runFor(sensors, 2500);
+
+	CHECK(intervalCalls >= 6);
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		int8_t index = sensors.getIndex(bus.oneWire.sensor(i).rom);
+		CHECK(index >= 0);
+		CHECK_EQUAL(bus.oneWire.sensor(i).temperature * 8, sensors.getTemperatureRAW(index));
+		CHECK_EQUAL(bus.oneWire.sensor(i).temperature * 8, lastRAW[index]);
+	}
+	CHECK(sensors.getTemperatureC(sensors.getIndex(bus.oneWire.sensor(1).rom)) == -10.25f);
+}
+
+static void followsTheTemperature()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+	CHECK_EQUAL(celsiusToRAW(20), sensors.getTemperatureRAW((uint8_t)0));
+	sensor.setCelsius(-0.5f);
+	runFor(sensors, 1500);
+	CHECK_EQUAL(celsiusToRAW(-0.5f), sensors.getTemperatureRAW((uint8_t)0));
+}
+
+static void appliesTheResolution()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20.0625f);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+
+	sensors.begin(NonBlockingDallas::resolution_9, 1000);
+	CHECK_EQUAL(9, bus.oneWire.sensor(0).resolution());
+	runFor(sensors, 1500);
+	CHECK_EQUAL(celsiusToRAW(20), sensors.getTemperatureRAW((uint8_t)0)); // 0.5 °C steps
+}
+
+static void readsNegativeTemperaturesWithSkipRom()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, -10.125f);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	CHECK(sensors.isSkipRomActive());
+	runFor(sensors, 1500);
+	CHECK_EQUAL(celsiusToRAW(-10.125f), sensors.getTemperatureRAW((uint8_t)0));
+
+	sensors.setFastRead(4);
+	sensor.setCelsius(-40);
+	runFor(sensors, 5000);
+	CHECK_EQUAL(celsiusToRAW(-40), sensors.getTemperatureRAW((uint8_t)0));
+	sensor.setCelsius(-0.0625f);
+	runFor(sensors, 5000);
+	CHECK_EQUAL(celsiusToRAW(-0.0625f), sensors.getTemperatureRAW((uint8_t)0));
+}
+
+static void updateDoesNotBlock()
+{
+	HostBus bus;
+	for (uint8_t i = 1; i <= 4; i++)
+		bus.oneWire.addSensor(i, 20 + i);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+
+	unsigned long longest = 0;
+	unsigned long end = millis() + 5000;
+	while ((long)(millis() - end) < 0)
+	{
+		unsigned long start = micros();
+		sensors.update();
+		if (micros() - start > longest)
+			longest = micros() - start;
+		host::advanceMillis(1);
+	}
+	CHECK(longest < 750000 / 10); // Far from the conversion time
+}
+
+static void slicesTheAddressedRequests()
+{
+	HostBus bus;
+	for (uint8_t i = 1; i <= 8; i++)
+		bus.oneWire.addSensor(i, 20 + i);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 5000);
+	sensors.setReadoutSlice(1);
+	for (uint8_t i = 0; i < 3; i++)
+		CHECK(sensors.setSensorInterval(sensors.getIndex(bus.oneWire.sensor(i).rom), 1000)); // 3 of 8 due, addressed
+	runFor(sensors, 6000);
+
+	SimulatedSensor &fast = bus.oneWire.sensor(0);
+	fast.setCelsius(-3.5f);
+	uint32_t fastConversions = fast.conversions;
+	uint32_t slowConversions = bus.oneWire.sensor(7).conversions;
+	unsigned long longest = 0;
+	unsigned long end = millis() + 4000;
+	while ((long)(millis() - end) < 0)
+	{
+		unsigned long start = micros();
+		sensors.update();
+		if (micros() - start > longest)
+			longest = micros() - start;
+		host::advanceMillis(1);
+	}
+	CHECK(fast.conversions - fastConversions >= 3);
+	CHECK(bus.oneWire.sensor(7).conversions - slowConversions < fast.conversions - fastConversions);
+	CHECK_EQUAL(celsiusToRAW(-3.5f), sensors.getTemperatureRAW(sensors.getIndex(fast.rom)));
+	CHECK(longest < 15000); // A single Match ROM request or read, no scratchpad read before the request
+}
+
+static NonBlockingDallas *exported;
+static uint8_t record[NonBlockingDallas::getCycleRecordSize(1)];
+static size_t recordLength;
+static unsigned long conversionMillis, readMillis;
+static bool sampleTimed;
+
+static void handleCycleComplete(const int32_t *, uint8_t, const uint8_t *, const uint8_t *)
+{
+	recordLength = exported->exportCycle(record, sizeof(record));
+	sampleTimed = exported->getSampleTimes(0, conversionMillis, readMillis);
+}
+
+static void timesTheSamplesWhenAttached()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	exported = &sensors;
+	sensors.onCycleComplete(handleCycleComplete);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+	CHECK_EQUAL(sizeof(record), recordLength);
+	CHECK_EQUAL(0xFFFF, record[12 + 3] | (record[12 + 4] << 8));
+	CHECK(!sampleTimed);
+
+	NonBlockingDallasTimingsN<ONE_WIRE_MAX_DEV> timings;
+	sensors.attachTimings(&timings);
+	runFor(sensors, 2000);
+	CHECK_EQUAL(sizeof(record), recordLength);
+	CHECK_EQUAL(0, record[12 + 3] | (record[12 + 4] << 8)); // Broadcast at the start of the cycle
+	CHECK(sampleTimed);
+	CHECK(readMillis - conversionMillis >= 750);
+	CHECK_EQUAL(readMillis - conversionMillis, record[12 + 5] | (record[12 + 6] << 8));
+}
+
+static uint8_t cycleValid[1], cycleChanged[1];
+static uint8_t cycleSensors, cyclesCount;
+
+static void handleCycleMasks(const int32_t *, uint8_t sensorsCount, const uint8_t *validMask, const uint8_t *changedMask)
+{
+	cycleSensors = sensorsCount;
+	cycleValid[0] = validMask[0];
+	cycleChanged[0] = changedMask[0];
+	cyclesCount++;
+}
+
+static void masksTheCycle()
+{
+	HostBus bus;
+	SimulatedSensor &unplugged = bus.oneWire.addSensor(1, 20);
+	SimulatedSensor &steady = bus.oneWire.addSensor(2, 21);
+	SimulatedSensor &moving = bus.oneWire.addSensor(3, 22);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	sensors.onCycleComplete(handleCycleMasks);
+	cyclesCount = 0;
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 1500);
+	CHECK_EQUAL(1, cyclesCount);
+	CHECK_EQUAL(3, cycleSensors);
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		CHECK(NonBlockingDallas::isMaskSet(cycleValid, i));
+		CHECK(NonBlockingDallas::isMaskSet(cycleChanged, i)); // First readings
+	}
+
+	unplugged.present = false;
+	moving.setCelsius(23);
+	runFor(sensors, 1000);
+	CHECK_EQUAL(2, cyclesCount);
+	CHECK_EQUAL(3, cycleSensors);
+	uint8_t unpluggedIndex = sensors.getIndex(unplugged.rom);
+	uint8_t steadyIndex = sensors.getIndex(steady.rom);
+	uint8_t movingIndex = sensors.getIndex(moving.rom);
+	CHECK(!NonBlockingDallas::isMaskSet(cycleValid, unpluggedIndex));
+	CHECK(!NonBlockingDallas::isMaskSet(cycleChanged, unpluggedIndex));
+	CHECK(NonBlockingDallas::isMaskSet(cycleValid, steadyIndex));
+	CHECK(!NonBlockingDallas::isMaskSet(cycleChanged, steadyIndex));
+	CHECK(NonBlockingDallas::isMaskSet(cycleValid, movingIndex));
+	CHECK(NonBlockingDallas::isMaskSet(cycleChanged, movingIndex));
+	CHECK_EQUAL(0, cycleValid[0] >> 3); // No bit beyond the sensors
+	CHECK_EQUAL(0, cycleChanged[0] >> 3);
+}
+
+int main()
+{
+	RUN_TEST(readsAllSensors);
+	RUN_TEST(followsTheTemperature);
+	RUN_TEST(appliesTheResolution);
+	RUN_TEST(readsNegativeTemperaturesWithSkipRom);
+	RUN_TEST(updateDoesNotBlock);
+	RUN_TEST(slicesTheAddressedRequests);
+	RUN_TEST(timesTheSamplesWhenAttached);
+	RUN_TEST(masksTheCycle);
+	return hostResult();
+}
@@ -0,0 +1,116 @@
+#include <HostTest.h>
+#include <NonBlockingDallasThresholds.h>
+#include <NonBlockingDallasAdaptive.h>
+
+static void switchesWithoutSavingTheEeprom()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasThresholdsN<ONE_WIRE_MAX_DEV> thresholds;
+	NonBlockingDallasAdaptiveN<ONE_WIRE_MAX_DEV> adaptive;
+	sensors.attachThresholds(&thresholds);
+	sensors.attachAdaptive(&adaptive);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	sensors.setThresholds(0, celsiusToRAW(0), celsiusToRAW(30));
+	sensors.setAdaptiveResolution(NonBlockingDallas::resolution_9, NonBlockingDallas::resolution_12, 2 * 128);
+	uint32_t eepromWrites = sensor.eepromWrites;
+	host::resetDelayedMillis();
+
+	runFor(sensors, 3000);
+	CHECK_EQUAL(9, sensors.getSensorResolution(0));
+	CHECK_EQUAL(9, sensor.resolution());
+	sensor.setCelsius(29);
+	runFor(sensors, 3000);
+	CHECK_EQUAL(12, sensors.getSensorResolution(0));
+	CHECK_EQUAL(celsiusToRAW(29), sensors.getTemperatureRAW((uint8_t)0));
+
+	CHECK_EQUAL(eepromWrites, sensor.eepromWrites);
+	CHECK_EQUAL(0, host::delayedMillis());
+	CHECK_EQUAL(0x7F, sensor.eeprom[2]); // 12 bits of begin() kept for the next power on
+}
+
+static void holdsTheNearResolution()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 29);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasThresholdsN<ONE_WIRE_MAX_DEV> thresholds;
+	NonBlockingDallasAdaptiveN<ONE_WIRE_MAX_DEV> adaptive;
+	sensors.attachThresholds(&thresholds);
+	sensors.attachAdaptive(&adaptive);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	sensors.setThresholds(0, celsiusToRAW(0), celsiusToRAW(30));
+	sensors.setAdaptiveResolution(NonBlockingDallas::resolution_9, NonBlockingDallas::resolution_12, 2 * 128);
+	runFor(sensors, 2000);
+
+	// Near and far from the threshold on alternate readings
+	uint8_t switches = 0;
+	uint8_t bits = sensors.getSensorResolution(0);
+	for (uint8_t n = 0; n < 20; n++)
+	{
+		sensor.setCelsius(n & 1 ? 29 : 26);
+		for (uint16_t ms = 0; ms < 1000; ms++)
+		{
+			sensors.update();
+			host::advanceMillis(1);
+			if (sensors.getSensorResolution(0) != bits)
+			{
+				bits = sensors.getSensorResolution(0);
+				switches++;
+			}
+		}
+	}
+	CHECK_EQUAL(0, switches);
+
+	// Back to the far resolution once the temperature stays far
+	sensor.setCelsius(20);
+	runFor(sensors, 8000);
+	CHECK_EQUAL(9, sensors.getSensorResolution(0));
+}
+
+static void keepsTheCachedResolutions()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	uint8_t cache[NonBlockingDallas::getCacheSize(1)];
+	{
+		NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+		NonBlockingDallasThresholdsN<ONE_WIRE_MAX_DEV> thresholds;
+		NonBlockingDallasAdaptiveN<ONE_WIRE_MAX_DEV> adaptive;
+		sensors.attachThresholds(&thresholds);
+		sensors.attachAdaptive(&adaptive);
+		sensors.begin(NonBlockingDallas::resolution_12, 1000);
+		sensors.setThresholds(0, celsiusToRAW(0), celsiusToRAW(30));
+		sensors.setAdaptiveResolution(NonBlockingDallas::resolution_9, NonBlockingDallas::resolution_12, 2 * 128);
+		runFor(sensors, 3000);
+		CHECK_EQUAL(9, sensors.getSensorResolution(0));
+		CHECK_EQUAL(sizeof(cache), sensors.exportCache(cache, sizeof(cache)));
+	}
+
+	// Restarted with the adaptive mode off, the sensor still converts at 9 bits
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	NonBlockingDallasThresholdsN<ONE_WIRE_MAX_DEV> thresholds;
+	NonBlockingDallasAdaptiveN<ONE_WIRE_MAX_DEV> adaptive;
+	sensors.attachThresholds(&thresholds);
+	sensors.attachAdaptive(&adaptive);
+	CHECK(sensors.beginFromCache(cache, sizeof(cache), NonBlockingDallas::resolution_12, 1000));
+	runFor(sensors, 3000);
+	CHECK_EQUAL(9, sensors.getSensorResolution(0));
+	CHECK_EQUAL(9, sensor.resolution());
+
+	// Turning the mode off restores the begin() resolution
+	sensors.setAdaptiveResolution(NonBlockingDallas::resolution_9, NonBlockingDallas::resolution_12, 2 * 128);
+	sensors.setAdaptiveResolution(NonBlockingDallas::resolution_9, NonBlockingDallas::resolution_12, 0);
+	runFor(sensors, 2000);
+	CHECK_EQUAL(12, sensors.getSensorResolution(0));
+	CHECK_EQUAL(12, sensor.resolution());
+}
+
+int main()
+{
+	RUN_TEST(switchesWithoutSavingTheEeprom);
+	RUN_TEST(holdsTheNearResolution);
+	RUN_TEST(keepsTheCachedResolutions);
+	return hostResult();
+}
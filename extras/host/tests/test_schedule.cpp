@@ -0,0 +1,117 @@
+#include <HostTest.h>
+
+static int scheduleCalls;
+
+static void handleScheduleChange(unsigned long)
+{
+	scheduleCalls++;
+}
+
+static void pollsEachCallWithoutTimedWait()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	sensors.update(); // Requests the first conversion
+	CHECK_EQUAL(1, sensor.conversions);
+	CHECK_EQUAL(0, sensors.millisToNextUpdate());
+
+	sensors.setTimedWait(true);
+	CHECK(sensors.millisToNextUpdate() > 500); // Not polled before the expected end
+}
+
+static void sleepsThroughTheConversions()
+{
+	HostBus bus;
+	SimulatedSensor &sensor = bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	sensors.setTimedWait(true);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	sensor.setCelsius(23.5f);
+
+	uint32_t updates = 0;
+	unsigned long end = millis() + 10000;
+	while ((long)(millis() - end) < 0)
+	{
+		sensors.update();
+		updates++;
+		unsigned long sleep = sensors.millisToNextUpdate();
+		host::advanceMillis(sleep > 0 ? (sleep < 1000 ? sleep : 1000) : 1);
+	}
+	CHECK_EQUAL(celsiusToRAW(23.5f), sensors.getTemperatureRAW((uint8_t)0));
+	CHECK(sensor.conversions >= 9);
+	CHECK(updates < 200); // A few polls per conversion instead of one per millisecond
+}
+
+static void wakesTheCallerOnSettings()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	sensors.onScheduleChange(handleScheduleChange);
+	scheduleCalls = 0;
+
+	sensors.setTimedWait(true);
+	CHECK_EQUAL(1, scheduleCalls);
+	sensors.setMergeWindow(100);
+	CHECK_EQUAL(2, scheduleCalls);
+	sensors.setAdaptiveInterval(1000, 10000, 8, 128);
+	CHECK_EQUAL(3, scheduleCalls);
+	sensors.setDiscovery(8, 2000);
+	CHECK_EQUAL(4, scheduleCalls);
+}
+
+enum mergeWindowCall
+{
+	noMergeWindow,
+	mergeWindowBeforeBegin,
+	mergeWindowAfterBegin
+};
+
+static int slowIndex;
+static uint32_t slowReadings;
+
+static void handleSlowReading(int deviceIndex, int32_t)
+{
+	if (deviceIndex == slowIndex)
+		slowReadings++;
+}
+
+// Readings of a sensor read every 1500 ms next to one read every second
+static uint32_t slowSensorReadings(mergeWindowCall call)
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	SimulatedSensor &slow = bus.oneWire.addSensor(2, 21);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	if (call == mergeWindowBeforeBegin)
+		sensors.setMergeWindow(0);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	if (call == mergeWindowAfterBegin)
+		sensors.setMergeWindow(0);
+	slowIndex = sensors.getIndex(slow.rom);
+	sensors.setSensorInterval(slowIndex, 1500);
+	sensors.onIntervalElapsed(handleSlowReading);
+	slowReadings = 0;
+	runFor(sensors, 9000);
+	return slowReadings;
+}
+
+static void keepsTheMergeWindowSetBeforeBegin()
+{
+	uint32_t merged = slowSensorReadings(noMergeWindow); // Read early with the other sensor
+	uint32_t notMerged = slowSensorReadings(mergeWindowAfterBegin);
+	CHECK(notMerged < merged);
+	CHECK_EQUAL(notMerged, slowSensorReadings(mergeWindowBeforeBegin));
+}
+
+int main()
+{
+	RUN_TEST(pollsEachCallWithoutTimedWait);
+	RUN_TEST(sleepsThroughTheConversions);
+	RUN_TEST(wakesTheCallerOnSettings);
+	RUN_TEST(keepsTheMergeWindowSetBeforeBegin);
+	return hostResult();
+}
@@ -0,0 +1,89 @@
+#include <HostTest.h>
+#include <NonBlockingDallasSnapshot.h>
+#include <atomic>
+#include <thread>
+
+static void publishesTheLastCycle()
+{
+	HostBus bus;
+	bus.oneWire.addSensor(1, 20);
+	SimulatedSensor &sensor = bus.oneWire.addSensor(2, 21);
+	NonBlockingDallas sensors(&bus.dallasTemp);
+	NonBlockingDallasSnapshotN<ONE_WIRE_MAX_DEV> snapshot;
+	sensors.attachSnapshot(&snapshot);
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+
+	int32_t temperatures[ONE_WIRE_MAX_DEV];
+	uint8_t validMask[(ONE_WIRE_MAX_DEV + 7) / 8];
+	uint32_t cycle = 1;
+	CHECK_EQUAL(0, snapshot.read(temperatures, ONE_WIRE_MAX_DEV, &cycle));
+	CHECK_EQUAL(0, cycle);
+
+	runFor(sensors, 2500);
+	sensor.setCelsius(-4);
+	runFor(sensors, 1000);
+	CHECK_EQUAL(2, snapshot.read(temperatures, ONE_WIRE_MAX_DEV, &cycle, validMask));
+	CHECK_EQUAL(sensors.getCycleCount(), cycle);
+	CHECK_EQUAL(snapshot.getCycle(), cycle);
+	CHECK_EQUAL(3, validMask[0]);
+	int8_t index = sensors.getIndex(sensor.rom);
+	CHECK_EQUAL(celsiusToRAW(-4), temperatures[index]);
+	CHECK_EQUAL(celsiusToRAW(20), temperatures[1 - index]);
+}
+
+static void readsConsistentCyclesFromAnotherThread()
+{
+	const uint8_t sensorsCount = 32;
+	NonBlockingDallasSnapshotN<sensorsCount> snapshot;
+	std::atomic<bool> done(false);
+	uint32_t torn = 0;
+	uint32_t copies = 0;
+
+	// Each cycle publishes its own number in every slot, a copy mixing two cycles shows up at once
+	std::thread reader([&]() {
+		int32_t temperatures[sensorsCount];
+		uint8_t validMask[(sensorsCount + 7) / 8];
+		while (!done)
+		{
+			uint32_t cycle;
+			uint8_t count = snapshot.read(temperatures, sensorsCount, &cycle, validMask);
+			if (count == 0)
+				continue;
+			copies++;
+			for (uint8_t i = 0; i < count; i++)
+			{
+				if (temperatures[i] != (int32_t)cycle)
+					torn++;
+			}
+			for (uint8_t i = 0; i < sizeof(validMask); i++)
+			{
+				if (validMask[i] != (uint8_t)cycle)
+					torn++;
+			}
+		}
+	});
+
+	int32_t temperatures[sensorsCount];
+	uint8_t validMask[(sensorsCount + 7) / 8];
+	for (uint32_t cycle = 1; cycle <= 2000000; cycle++)
+	{
+		for (uint8_t i = 0; i < sensorsCount; i++)
+			temperatures[i] = cycle;
+		for (uint8_t i = 0; i < sizeof(validMask); i++)
+			validMask[i] = (uint8_t)cycle;
+		snapshot.publish(temperatures, validMask, sensorsCount);
+	}
+	done = true;
+	reader.join();
+
+	CHECK(copies > 0);
+	CHECK_EQUAL(0, torn);
+	CHECK_EQUAL(2000000, snapshot.getCycle());
+}
+
+int main()
+{
+	RUN_TEST(publishesTheLastCycle);
+	RUN_TEST(readsConsistentCyclesFromAnotherThread);
+	return hostResult();
+}
@@ -0,0 +1,95 @@
+#include <HostTest.h>
+#include <NonBlockingDallasTrace.h>
+#include <new>
+
+struct reading
+{
+	int deviceIndex;
+	int32_t temperatureRAW;
+};
+
+static reading readings[64];
+static uint8_t readingsCount;
+
+static void handleIntervalElapsed(int deviceIndex, int32_t temperatureRAW)
+{
+	if (readingsCount < 64)
+		readings[readingsCount++] = {deviceIndex, temperatureRAW};
+}
+
+static void startsEmpty()
+{
+	// Filled with garbage first, so that a member left out by the constructor shows up
+	alignas(NonBlockingDallasTraceN<64>) static uint8_t memory[sizeof(NonBlockingDallasTraceN<64>)];
+	volatile uint8_t *garbage = memory; // Volatile, not dropped as a store before the constructor
+	for (size_t i = 0; i < sizeof(memory); i++)
+		garbage[i] = 0xA5;
+	NonBlockingDallasTraceN<64> *trace = new (memory) NonBlockingDallasTraceN<64>();
+	CHECK_EQUAL(NonBlockingDallasTrace::idle, trace->getMode());
+	CHECK_EQUAL(0, trace->getLength());
+	CHECK_EQUAL(0, trace->getRecordCount());
+	CHECK_EQUAL(0, trace->getBusMicros());
+	CHECK_EQUAL(0, trace->getMismatches());
+	CHECK(!trace->isOverflowed());
+	CHECK(trace->isReplayFinished());
+	CHECK(!trace->isParasite());
+	trace->~NonBlockingDallasTraceN<64>();
+}
+
+static void replaysACapturedTrace()
+{
+	NonBlockingDallasTraceN<2048> trace;
+	reading recorded[64];
+	uint8_t recordedCount;
+	{
+		HostBus bus;
+		SimulatedSensor &first = bus.oneWire.addSensor(1, 20);
+		bus.oneWire.addSensor(2, -5.5f);
+		bus.oneWire.addSensor(3, 31.25f);
+		NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+		sensors.onIntervalElapsed(handleIntervalElapsed);
+		sensors.attachTrace(&trace);
+		readingsCount = 0;
+		trace.startRecording();
+		sensors.begin(NonBlockingDallas::resolution_12, 1000);
+		runFor(sensors, 2500);
+		first.setCelsius(22.5f);
+		runFor(sensors, 2500);
+		trace.stop();
+		CHECK(!trace.isOverflowed());
+		recordedCount = readingsCount;
+		memcpy(recorded, readings, sizeof(recorded));
+	}
+	CHECK(recordedCount >= 12);
+
+	// No sensor on the bus, every answer comes from the trace
+	HostBus bus;
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.onIntervalElapsed(handleIntervalElapsed);
+	sensors.attachTrace(&trace);
+	readingsCount = 0;
+	CHECK(trace.startReplay(trace.getData(), trace.getLength()));
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	CHECK_EQUAL(3, sensors.getSensorsCount());
+	for (uint32_t n = 0; n < 10000 && !trace.isReplayFinished(); n++)
+	{
+		sensors.update();
+		host::advanceMillis(1);
+	}
+	CHECK(trace.isReplayFinished());
+	CHECK_EQUAL(0, trace.getMismatches());
+	CHECK_EQUAL(0, bus.oneWire.busMicros);
+	CHECK(readingsCount >= recordedCount);
+	for (uint8_t i = 0; i < recordedCount && i < readingsCount; i++)
+	{
+		CHECK_EQUAL(recorded[i].deviceIndex, readings[i].deviceIndex);
+		CHECK_EQUAL(recorded[i].temperatureRAW, readings[i].temperatureRAW);
+	}
+}
+
+int main()
+{
+	RUN_TEST(startsEmpty);
+	RUN_TEST(replaysACapturedTrace);
+	return hostResult();
+}
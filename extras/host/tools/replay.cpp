@@ -0,0 +1,103 @@
+// Host build of NonBlockingDallas: replays a bus trace captured on a board, faster than real time
+//
+// nbd_replay <trace> [resolution] [interval]    Replay, begin() with the settings of the capture
+// nbd_replay --simulate <trace> [sensors]       Capture 10 s of the simulated bus, to try the replay
+//
+// Prints the readings, then the records replayed, their bus time and the operations not found
+// in the trace. The exit code is 1 if the trace is not valid or if an operation was not found.
+
+#include <HostTest.h>
+#include <NonBlockingDallasTrace.h>
+#include <stdlib.h>
+
+#define REPLAY_MAX_SIZE 65536
+#define REPLAY_MAX_MILLIS 86400000UL // A day of simulated time
+
+static NonBlockingDallasTraceN<REPLAY_MAX_SIZE> trace;
+static uint8_t data[REPLAY_MAX_SIZE];
+
+static void printReading(int deviceIndex, int32_t temperatureRAW)
+{
+	printf("%lu ms: sensor %d %.4f C\n", millis(), deviceIndex, temperatureRAW / 128.0);
+}
+
+static int simulate(const char *path, uint8_t sensorsCount)
+{
+	HostBus bus;
+	for (uint8_t i = 1; i <= sensorsCount; i++)
+		bus.oneWire.addSensor(i, 18 + i * 0.25f);
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.onIntervalElapsed(printReading);
+	sensors.attachTrace(&trace);
+	trace.startRecording();
+	sensors.begin(NonBlockingDallas::resolution_12, 1000);
+	runFor(sensors, 10000);
+	trace.stop();
+	if (trace.isOverflowed())
+	{
+		fprintf(stderr, "%s: trace overflowed\n", path);
+		return 1;
+	}
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL || fwrite(trace.getData(), 1, trace.getLength(), file) != trace.getLength())
+	{
+		fprintf(stderr, "%s: cannot write the trace\n", path);
+		if (file != NULL)
+			fclose(file);
+		return 1;
+	}
+	fclose(file);
+	printf("%lu records, %lu bytes\n", (unsigned long)trace.getRecordCount(), (unsigned long)trace.getLength());
+	return 0;
+}
+
+static int replay(const char *path, int bits, unsigned long intervalMillis)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "%s: cannot open the trace\n", path);
+		return 1;
+	}
+	size_t length = fread(data, 1, sizeof(data), file);
+	fclose(file);
+
+	// No sensor on the bus, every answer comes from the trace
+	HostBus bus;
+	NonBlockingDallas sensors(&bus.dallasTemp, &bus.oneWire);
+	sensors.onIntervalElapsed(printReading);
+	sensors.attachTrace(&trace);
+	if (!trace.startReplay(data, length))
+	{
+		fprintf(stderr, "%s: not a trace of version %d\n", path, TRACE_VERSION);
+		return 1;
+	}
+	sensors.begin((NonBlockingDallas::resolution)bits, intervalMillis);
+	for (unsigned long n = 0; n < REPLAY_MAX_MILLIS && !trace.isReplayFinished(); n++)
+	{
+		sensors.update();
+		host::advanceMillis(1);
+	}
+
+	printf("%lu records replayed, %lu us of bus time, %u not found\n", (unsigned long)trace.getRecordCount(),
+		   trace.getBusMicros(), trace.getMismatches());
+	return trace.getMismatches() == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 3 && strcmp(argv[1], "--simulate") == 0)
+		return simulate(argv[2], argc >= 4 ? atoi(argv[3]) : 4);
+	if (argc < 2 || argv[1][0] == '-')
+	{
+		fprintf(stderr, "usage: %s <trace> [resolution] [interval]\n"
+						"       %s --simulate <trace> [sensors]\n",
+				argv[0], argv[0]);
+		return 2;
+	}
+	int bits = argc >= 3 ? atoi(argv[2]) : 12;
+	if (bits < 9 || bits > 12)
+		bits = 12;
+	return replay(argv[1], bits, argc >= 4 ? strtoul(argv[3], NULL, 10) : 1000);
+}